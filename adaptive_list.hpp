@@ -0,0 +1,528 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "list.hpp"
+
+// List that moves its elements into one contiguous array while it is only
+// being read, and back into linked nodes once it is structurally modified.
+//
+// Every begin() and for_each counts as a traversal. When kFreezeAfter
+// traversals (doubled after each freeze that did not pay off) have run
+// since the last structural mutation, and the list holds at least
+// kMinFreezeSize elements, the next traversal first freezes the list. A
+// freeze only happens when no iterator into the list is alive, so loops
+// that are already running are never pulled out from under. A frozen list
+// thaws on the first structural mutation: insert, emplace, push, pop,
+// erase or clear. A thaw that runs out of memory throws from that mutation
+// and leaves the list frozen and unchanged.
+//
+// Live iterators are counted in a small heap block they share with the
+// list. It belongs to the elements rather than the list object: move and
+// swap hand it over together with them, and a list destroyed while
+// iterators are alive leaves it to the last of them to free.
+//
+// Invalidation rules:
+//  - Linked, the rules are List's: only erasing invalidates, and only
+//    iterators and references to the erased element.
+//  - A freeze invalidates every pointer and reference to an element; there
+//    are no iterators left to invalidate.
+//  - A thaw invalidates every iterator, pointer and reference except the
+//    iterator insert or erase returns.
+//  - Writing through an iterator or reference never changes the layout.
+//  - Move construction, move assignment and swap invalidate nothing:
+//    iterators keep pointing at the same elements, now owned by the other
+//    list, and keep them from being frozen there.
+//
+// Traversals update counters even through a const list, so unlike List,
+// concurrent reads need external synchronization.
+template <typename T, typename Alloc = std::allocator<T>>
+class AdaptiveList {
+ private:
+  using list_type = List<T, Alloc>;
+  using array_type = std::vector<
+      T, typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
+
+  static constexpr size_t kFreezeAfter = 4;
+  static constexpr size_t kMaxFreezeAfter = 1024;
+  static constexpr size_t kMinFreezeSize = 16;
+
+  mutable list_type list_;
+  mutable array_type array_;
+  mutable bool frozen_ = false;
+
+  struct Pins {
+    size_t iterators = 0;
+    bool orphaned = false;
+
+    // Only iterators that outlive their list get here.
+    [[gnu::cold, gnu::noinline]] static void free_orphan(Pins* pins) {
+      delete pins;
+    }
+  };
+
+  mutable size_t traversals_ = 0;
+  mutable size_t freeze_after_ = kFreezeAfter;
+  // Created by the first iterator.
+  mutable Pins* pins_ = nullptr;
+
+  Pins* pins() const {
+    if (pins_ == nullptr) {
+      pins_ = new Pins;
+    }
+    return pins_;
+  }
+
+  bool pinned() const { return pins_ != nullptr && pins_->iterators != 0; }
+
+  void release_pins() {
+    if (pins_ == nullptr) {
+      return;
+    }
+    if (pins_->iterators == 0) {
+      delete pins_;
+    } else {
+      pins_->orphaned = true;
+    }
+    pins_ = nullptr;
+  }
+
+  // Moves the elements into array_, or copies them when moving may throw.
+  // Either all elements move or the list stays linked and intact.
+  void do_freeze() const {
+    array_.reserve(list_.size());
+    try {
+      for (T& val : list_) {
+        array_.push_back(std::move_if_noexcept(val));
+      }
+    } catch (...) {
+      array_.clear();
+      throw;
+    }
+    list_.clear();
+    frozen_ = true;
+    traversals_ = 0;
+  }
+
+  // Moves the elements back into nodes, or copies them when moving may
+  // throw. A failed allocation midway moves the linked elements back into
+  // their slots, so the list stays frozen with array_ as it was.
+  void do_thaw() {
+    if constexpr (std::is_nothrow_move_constructible_v<T> ||
+                  !std::is_copy_constructible_v<T>) {
+      try {
+        for (T& val : array_) {
+          list_.push_back(std::move(val));
+        }
+      } catch (...) {
+        auto slot = array_.begin();
+        for (T& val : list_) {
+          *slot++ = std::move(val);
+        }
+        list_.clear();
+        throw;
+      }
+    } else {
+      list_.push_back_n(array_.begin(), array_.end());
+    }
+
+    // Staying frozen for fewer traversals than it took to freeze means the
+    // two moves did not pay off; make the next freeze harder to reach.
+    if (traversals_ < freeze_after_) {
+      freeze_after_ = std::min(freeze_after_ * 2, kMaxFreezeAfter);
+    } else {
+      freeze_after_ = kFreezeAfter;
+    }
+
+    array_.clear();
+    array_.shrink_to_fit();
+    frozen_ = false;
+    traversals_ = 0;
+  }
+
+  void count_traversal() const {
+    if (!frozen_ && !pinned() && traversals_ >= freeze_after_ &&
+        list_.size() >= kMinFreezeSize) {
+      do_freeze();
+    }
+    traversals_++;
+  }
+
+  void mutated() {
+    if (frozen_) {
+      do_thaw();
+    }
+    traversals_ = 0;
+  }
+
+ public:
+  template <bool IsConst>
+  class Iterator;
+
+  using value_type = T;
+  using allocator_type = Alloc;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  AdaptiveList() = default;
+
+  explicit AdaptiveList(const Alloc& alloc) : list_(alloc), array_(alloc) {}
+
+  AdaptiveList(std::initializer_list<T> init, const Alloc& alloc = Alloc())
+      : list_(init, alloc), array_(alloc) {}
+
+  AdaptiveList(const AdaptiveList& other)
+      : list_(other.get_allocator()), array_(other.get_allocator()) {
+    for (const T& val : other.unsafe_view()) {
+      list_.push_back(val);
+    }
+  }
+
+  AdaptiveList(AdaptiveList&& other) noexcept
+      : list_(std::move(other.list_)),
+        array_(std::move(other.array_)),
+        frozen_(other.frozen_),
+        traversals_(other.traversals_),
+        freeze_after_(other.freeze_after_),
+        pins_(std::exchange(other.pins_, nullptr)) {
+    other.frozen_ = false;
+    other.traversals_ = 0;
+  }
+
+  AdaptiveList& operator=(const AdaptiveList& other) {
+    if (this != &other) {
+      AdaptiveList temp(other);
+      swap(temp);
+    }
+    return *this;
+  }
+
+  AdaptiveList& operator=(AdaptiveList&& other) {
+    if (this != &other) {
+      AdaptiveList temp(std::move(other));
+      swap(temp);
+    }
+    return *this;
+  }
+
+  ~AdaptiveList() { release_pins(); }
+
+  void swap(AdaptiveList& other) {
+    std::swap(list_, other.list_);
+    array_.swap(other.array_);
+    std::swap(frozen_, other.frozen_);
+    std::swap(traversals_, other.traversals_);
+    std::swap(freeze_after_, other.freeze_after_);
+    std::swap(pins_, other.pins_);
+  }
+
+  Alloc get_allocator() const { return list_.get_allocator(); }
+
+  bool frozen() const { return frozen_; }
+
+  size_t size() const { return frozen_ ? array_.size() : list_.size(); }
+
+  bool empty() const { return size() == 0; }
+
+  // Explicit layout control. freeze() may run with iterators alive, which
+  // it then invalidates.
+  void freeze() {
+    if (!frozen_) {
+      do_freeze();
+    }
+  }
+
+  void thaw() { mutated(); }
+
+  T& front() { return frozen_ ? array_.front() : list_.front(); }
+
+  const T& front() const { return frozen_ ? array_.front() : list_.front(); }
+
+  T& back() { return frozen_ ? array_.back() : list_.back(); }
+
+  const T& back() const { return frozen_ ? array_.back() : list_.back(); }
+
+  iterator begin() {
+    count_traversal();
+    return iterator(pins(), list_.begin(), array_.data(), frozen_);
+  }
+
+  iterator end() {
+    return iterator(pins(), list_.end(), array_.data() + array_.size(),
+                    frozen_);
+  }
+
+  const_iterator begin() const {
+    count_traversal();
+    return const_iterator(pins(), list_.begin(), array_.data(), frozen_);
+  }
+
+  const_iterator end() const {
+    return const_iterator(pins(), list_.end(), array_.data() + array_.size(),
+                          frozen_);
+  }
+
+  const_iterator cbegin() const { return begin(); }
+
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  const_reverse_iterator crbegin() const { return rbegin(); }
+
+  const_reverse_iterator crend() const { return rend(); }
+
+  // Traversal without iterators: the layout is checked once rather than on
+  // every step.
+  template <typename F>
+  void for_each(F func) {
+    count_traversal();
+    if (frozen_) {
+      std::for_each(array_.begin(), array_.end(), func);
+    } else {
+      std::for_each(list_.begin(), list_.end(), func);
+    }
+  }
+
+  template <typename F>
+  void for_each(F func) const {
+    count_traversal();
+    if (frozen_) {
+      std::for_each(array_.cbegin(), array_.cend(), func);
+    } else {
+      std::for_each(list_.cbegin(), list_.cend(), func);
+    }
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    mutated();
+    return list_.emplace_back(std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  T& emplace_front(Args&&... args) {
+    mutated();
+    return list_.emplace_front(std::forward<Args>(args)...);
+  }
+
+  void push_back(const T& val) { emplace_back(val); }
+
+  void push_back(T&& val) { emplace_back(std::move(val)); }
+
+  void push_front(const T& val) { emplace_front(val); }
+
+  void push_front(T&& val) { emplace_front(std::move(val)); }
+
+  void pop_back() {
+    mutated();
+    list_.pop_back();
+  }
+
+  void pop_front() {
+    mutated();
+    list_.pop_front();
+  }
+
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    auto where = linked_position(pos);
+    return iterator(pins(), list_.emplace(where, std::forward<Args>(args)...),
+                    nullptr, false);
+  }
+
+  iterator insert(const_iterator pos, const T& val) {
+    return emplace(pos, val);
+  }
+
+  iterator insert(const_iterator pos, T&& val) {
+    return emplace(pos, std::move(val));
+  }
+
+  iterator erase(const_iterator pos) {
+    auto where = linked_position(pos);
+    return iterator(pins(), list_.erase(where), nullptr, false);
+  }
+
+  void clear() {
+    if (frozen_) {
+      array_.clear();
+      array_.shrink_to_fit();
+      frozen_ = false;
+    }
+    list_.clear();
+    traversals_ = 0;
+  }
+
+  bool operator==(const AdaptiveList& other) const {
+    return std::ranges::equal(unsafe_view(), other.unsafe_view());
+  }
+
+ private:
+  // Iteration that neither counts nor freezes, for internal whole-list
+  // reads.
+  struct View {
+    const AdaptiveList* owner;
+
+    auto begin() const {
+      return const_iterator(owner->pins(), owner->list_.cbegin(),
+                            owner->array_.data(), owner->frozen_);
+    }
+
+    auto end() const { return owner->end(); }
+  };
+
+  View unsafe_view() const { return View{this}; }
+
+  // Thaws if needed and maps pos, which may point into the array, to the
+  // same position among the nodes.
+  typename list_type::const_iterator linked_position(const_iterator pos) {
+    if (!frozen_) {
+      traversals_ = 0;
+      return pos.node_;
+    }
+    auto index = pos.slot_ - array_.data();
+    mutated();
+    return std::next(list_.cbegin(), index);
+  }
+};
+
+// Bidirectional iterator over either layout. Each one is counted in its
+// list's Pins so that traversals never freeze the list underneath it; it
+// never touches the list itself, so it may outlive it.
+template <typename T, typename Alloc>
+template <bool IsConst>
+class AdaptiveList<T, Alloc>::Iterator {
+ private:
+  using node_iterator =
+      std::conditional_t<IsConst, typename list_type::const_iterator,
+                         typename list_type::iterator>;
+
+  Pins* pins_ = nullptr;
+  node_iterator node_;
+  T* slot_ = nullptr;
+  bool frozen_ = false;
+
+  template <bool>
+  friend class Iterator;
+
+  friend AdaptiveList;
+
+  Iterator(Pins* pins, node_iterator node, T* slot, bool frozen)
+      : pins_(pins), node_(node), slot_(slot), frozen_(frozen) {
+    attach();
+  }
+
+  void attach() {
+    if (pins_ != nullptr) {
+      pins_->iterators++;
+    }
+  }
+
+  void detach() {
+    if (pins_ != nullptr && --pins_->iterators == 0 && pins_->orphaned) {
+      Pins::free_orphan(pins_);
+    }
+  }
+
+ public:
+  using is_const = std::conditional_t<IsConst, const T, T>;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = std::remove_cv_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = is_const*;
+  using reference = is_const&;
+
+  Iterator() = default;
+
+  Iterator(const Iterator& other)
+      : pins_(other.pins_),
+        node_(other.node_),
+        slot_(other.slot_),
+        frozen_(other.frozen_) {
+    attach();
+  }
+
+  template <bool OtherConst>
+    requires(IsConst && !OtherConst)
+  Iterator(const Iterator<OtherConst>& other)
+      : pins_(other.pins_),
+        node_(other.node_),
+        slot_(other.slot_),
+        frozen_(other.frozen_) {
+    attach();
+  }
+
+  Iterator& operator=(const Iterator& other) {
+    if (this != &other) {
+      detach();
+      pins_ = other.pins_;
+      node_ = other.node_;
+      slot_ = other.slot_;
+      frozen_ = other.frozen_;
+      attach();
+    }
+    return *this;
+  }
+
+  ~Iterator() { detach(); }
+
+  Iterator& operator++() {
+    if (frozen_) {
+      ++slot_;
+    } else {
+      ++node_;
+    }
+    return *this;
+  }
+
+  Iterator operator++(int) {
+    auto temp(*this);
+    ++*this;
+    return temp;
+  }
+
+  Iterator& operator--() {
+    if (frozen_) {
+      --slot_;
+    } else {
+      --node_;
+    }
+    return *this;
+  }
+
+  Iterator operator--(int) {
+    auto temp(*this);
+    --*this;
+    return temp;
+  }
+
+  reference operator*() const { return frozen_ ? *slot_ : *node_; }
+
+  pointer operator->() const { return &**this; }
+
+  bool operator==(const Iterator& other) const {
+    return frozen_ ? slot_ == other.slot_ : node_ == other.node_;
+  }
+
+  bool operator!=(const Iterator& other) const { return !(*this == other); }
+};
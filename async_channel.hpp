@@ -0,0 +1,255 @@
+#pragma once
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+
+#include "list.hpp"
+
+// Fire-and-forget coroutine type: starts eagerly, frees its frame when it
+// finishes and terminates on an escaping exception. Enough to drive
+// channels on a single-threaded executor.
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {}; }
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void return_void() {}
+
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// Channel between coroutines of one thread. Buffered values live in a
+// List<T, Alloc>; suspended consumers and producers wait in FIFO rings of
+// intrusive TruncatedNodes that sit in their awaiters, so waiting allocates
+// nothing. A push that finds a waiting consumer hands the value over and
+// resumes the consumer inline before carrying on, and a pop that frees room
+// resumes the oldest blocked producer the same way. With a capacity, push
+// suspends while the buffer is full; capacity 0 makes every push a
+// rendezvous with a pop. Not thread-safe.
+template <typename T, typename Alloc = std::allocator<T>>
+class AsyncChannel {
+ private:
+  List<T, Alloc> items_;
+  size_t capacity_;
+  bool closed_ = false;
+
+  TruncatedNode consumers_;
+  TruncatedNode producers_;
+
+  // Waiters unlink themselves when their coroutine is destroyed while
+  // suspended.
+  struct Waiter : TruncatedNode {
+    std::coroutine_handle<> handle;
+
+    Waiter() : TruncatedNode(nullptr, nullptr) {}
+
+    Waiter(const Waiter&) = delete;
+    Waiter& operator=(const Waiter&) = delete;
+
+    ~Waiter() { unlink(); }
+
+    void link(TruncatedNode& ring) {
+      TruncatedNode::link_before(&ring, this);
+    }
+
+    void unlink() {
+      if (next != nullptr) {
+        TruncatedNode::unlink(this);
+        next = nullptr;
+        prev = nullptr;
+      }
+    }
+  };
+
+  struct PopWaiter;
+  struct PushWaiter;
+
+  static bool has_waiters(const TruncatedNode& ring) {
+    return ring.next != &ring;
+  }
+
+  PopWaiter* first_consumer() {
+    return static_cast<PopWaiter*>(consumers_.next);
+  }
+
+  PushWaiter* first_producer() {
+    return static_cast<PushWaiter*>(producers_.next);
+  }
+
+  // Tries to complete a push of val right away: hand-off to a waiting
+  // consumer or room in the buffer.
+  template <typename U>
+  bool push_now(U&& val) {
+    if (has_waiters(consumers_)) {
+      PopWaiter* consumer = first_consumer();
+      consumer->unlink();
+      consumer->result.emplace(std::forward<U>(val));
+      consumer->handle.resume();
+      return true;
+    }
+
+    if (items_.size() < capacity_) {
+      items_.push_back(std::forward<U>(val));
+      return true;
+    }
+
+    return false;
+  }
+
+  // Tries to complete a pop into out right away. A blocked producer is
+  // resumed once its value has been taken.
+  bool pop_now(std::optional<T>& out) {
+    if (!items_.empty()) {
+      out.emplace(std::move(items_.front()));
+      items_.pop_front();
+
+      if (has_waiters(producers_)) {
+        PushWaiter* producer = first_producer();
+        producer->unlink();
+        items_.push_back(std::move(producer->value));
+        producer->accepted = true;
+        producer->handle.resume();
+      }
+      return true;
+    }
+
+    if (has_waiters(producers_)) {
+      PushWaiter* producer = first_producer();
+      producer->unlink();
+      out.emplace(std::move(producer->value));
+      producer->accepted = true;
+      producer->handle.resume();
+      return true;
+    }
+
+    return closed_;
+  }
+
+ public:
+  using value_type = T;
+
+  static constexpr size_t kUnbounded = SIZE_MAX;
+
+  explicit AsyncChannel(size_t capacity = kUnbounded,
+                        const Alloc& alloc = Alloc())
+      : items_(alloc), capacity_(capacity) {}
+
+  AsyncChannel(const AsyncChannel&) = delete;
+  AsyncChannel& operator=(const AsyncChannel&) = delete;
+
+  // Waiters have to be gone (resumed or destroyed) by now.
+  ~AsyncChannel() = default;
+
+  size_t size() const { return items_.size(); }
+
+  size_t capacity() const { return capacity_; }
+
+  bool closed() const { return closed_; }
+
+  class PopAwaiter;
+  class PushAwaiter;
+
+  // co_await channel.pop() yields the next value, or std::nullopt once the
+  // channel is closed and drained.
+  PopAwaiter pop() { return PopAwaiter(this); }
+
+  // co_await channel.push(val) yields false if the channel was closed
+  // before the value got in.
+  PushAwaiter push(T val) { return PushAwaiter(this, std::move(val)); }
+
+  // Non-suspending variants for code outside coroutines.
+  bool try_push(const T& val) { return !closed_ && push_now(val); }
+
+  bool try_push(T&& val) { return !closed_ && push_now(std::move(val)); }
+
+  std::optional<T> try_pop() {
+    std::optional<T> out;
+    pop_now(out);
+    return out;
+  }
+
+  // Wakes every waiter: consumers get std::nullopt once the buffer is
+  // empty, blocked producers get false. Buffered values can still be
+  // popped.
+  void close() {
+    closed_ = true;
+
+    while (has_waiters(consumers_)) {
+      PopWaiter* consumer = first_consumer();
+      consumer->unlink();
+      consumer->handle.resume();
+    }
+
+    while (has_waiters(producers_)) {
+      PushWaiter* producer = first_producer();
+      producer->unlink();
+      producer->accepted = false;
+      producer->handle.resume();
+    }
+  }
+};
+
+template <typename T, typename Alloc>
+struct AsyncChannel<T, Alloc>::PopWaiter : Waiter {
+  std::optional<T> result;
+};
+
+template <typename T, typename Alloc>
+struct AsyncChannel<T, Alloc>::PushWaiter : Waiter {
+  T value;
+  bool accepted = false;
+
+  explicit PushWaiter(T&& val) : value(std::move(val)) {}
+};
+
+template <typename T, typename Alloc>
+class AsyncChannel<T, Alloc>::PopAwaiter {
+ private:
+  AsyncChannel* channel_;
+  PopWaiter waiter_;
+
+ public:
+  explicit PopAwaiter(AsyncChannel* channel) : channel_(channel) {}
+
+  bool await_ready() { return channel_->pop_now(waiter_.result); }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    waiter_.handle = handle;
+    waiter_.link(channel_->consumers_);
+  }
+
+  std::optional<T> await_resume() { return std::move(waiter_.result); }
+};
+
+template <typename T, typename Alloc>
+class AsyncChannel<T, Alloc>::PushAwaiter {
+ private:
+  AsyncChannel* channel_;
+  PushWaiter waiter_;
+
+ public:
+  PushAwaiter(AsyncChannel* channel, T&& val)
+      : channel_(channel), waiter_(std::move(val)) {}
+
+  bool await_ready() {
+    if (channel_->closed_) {
+      return true;
+    }
+    waiter_.accepted = channel_->push_now(std::move(waiter_.value));
+    return waiter_.accepted;
+  }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    waiter_.handle = handle;
+    waiter_.link(channel_->producers_);
+  }
+
+  bool await_resume() { return waiter_.accepted; }
+};
@@ -0,0 +1,1108 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <malloc.h>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "adaptive_list.hpp"
+#include "async_channel.hpp"
+#include "bounded_list.hpp"
+#include "concurrent_list.hpp"
+#include "deferred_list.hpp"
+#include "huge_page_allocator.hpp"
+#include "list.hpp"
+#include "lru_cache.hpp"
+#include "profiling_allocator.hpp"
+#include "rcu_list.hpp"
+#include "sharded_list.hpp"
+#include "thread_executor.hpp"
+#include "timer_wheel.hpp"
+
+using BenchClock = std::chrono::steady_clock;
+
+template <typename F>
+double MeasureSeconds(F func) {
+  auto start = BenchClock::now();
+  func();
+  return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+void Report(const std::string& name, const std::string& params, double ops,
+            double seconds) {
+  std::cout << name << " " << params << ": " << ops / seconds / 1e6
+            << " Mops/s (" << seconds << " s)\n";
+}
+
+template <typename F>
+double RunThreads(size_t threads, F func) {
+  return MeasureSeconds([&] {
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+      workers.emplace_back(func, t);
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  });
+}
+
+class GlobalLockSortedList {
+ private:
+  std::mutex mutex_;
+  std::list<int> list_;
+
+ public:
+  bool insert(int val) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::lower_bound(list_.begin(), list_.end(), val);
+    if (it != list_.end() && *it == val) {
+      return false;
+    }
+    list_.insert(it, val);
+    return true;
+  }
+
+  bool erase(int val) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::lower_bound(list_.begin(), list_.end(), val);
+    if (it == list_.end() || *it != val) {
+      return false;
+    }
+    list_.erase(it);
+    return true;
+  }
+
+  bool contains(int val) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::lower_bound(list_.begin(), list_.end(), val);
+    return it != list_.end() && *it == val;
+  }
+};
+
+// 80% contains, 10% insert, 10% erase over a key range of kKeys.
+template <typename SortedList>
+void MixedSortedWorkload(const std::string& name, size_t threads) {
+  constexpr int kKeys = 2048;
+  constexpr size_t kOpsPerThread = 20000;
+
+  SortedList lst;
+  for (int i = 0; i < kKeys; i += 2) {
+    lst.insert(i);
+  }
+
+  double seconds = RunThreads(threads, [&lst](size_t t) {
+    std::mt19937 gen(static_cast<unsigned>(t + 1));
+    std::uniform_int_distribution<int> key(0, kKeys - 1);
+    std::uniform_int_distribution<int> kind(0, 9);
+
+    for (size_t i = 0; i < kOpsPerThread; ++i) {
+      int op = kind(gen);
+      if (op == 0) {
+        lst.insert(key(gen));
+      } else if (op == 1) {
+        lst.erase(key(gen));
+      } else {
+        lst.contains(key(gen));
+      }
+    }
+  });
+
+  Report(name, "threads=" + std::to_string(threads),
+         static_cast<double>(threads * kOpsPerThread), seconds);
+}
+
+void BENCH_CONCURRENT_LIST() {
+  for (size_t threads : {1, 2, 4, 8, 16}) {
+    MixedSortedWorkload<ConcurrentSortedList<int>>("hand_over_hand", threads);
+    MixedSortedWorkload<GlobalLockSortedList>("global_mutex", threads);
+  }
+}
+
+void BENCH_BATCH() {
+  constexpr size_t kBatch = 4096;
+  constexpr size_t kRounds = 2000;
+
+  std::vector<int> batch(kBatch);
+  std::iota(batch.begin(), batch.end(), 0);
+
+  for (int mode = 0; mode < 2; ++mode) {
+    List<int> lst;
+    std::vector<int> sink;
+    sink.reserve(kBatch);
+
+    double seconds = MeasureSeconds([&] {
+      for (size_t round = 0; round < kRounds; ++round) {
+        if (mode == 0) {
+          for (int val : batch) {
+            lst.push_back(val);
+          }
+          while (!lst.empty()) {
+            sink.push_back(std::move(*lst.begin()));
+            lst.pop_front();
+          }
+        } else {
+          lst.push_back_n(batch.begin(), batch.end());
+          lst.pop_front_n(kBatch, std::back_inserter(sink));
+        }
+        sink.clear();
+      }
+    });
+
+    Report(mode == 0 ? "per_element_ingest" : "batched_ingest",
+           "batch=" + std::to_string(kBatch),
+           static_cast<double>(kBatch * kRounds), seconds);
+  }
+}
+
+struct Event {
+  uint64_t timestamp;
+  uint32_t kind;
+  uint32_t payload;
+};
+
+void BENCH_BOUNDED() {
+  constexpr size_t kCapacity = 1024;
+  constexpr size_t kEvents = 100'000'000;
+
+  {
+    List<Event> lst;
+    double seconds = MeasureSeconds([&lst] {
+      for (size_t i = 0; i < kEvents; ++i) {
+        lst.push_back(Event{i, static_cast<uint32_t>(i & 7), 0});
+        if (lst.size() > kCapacity) {
+          lst.pop_front();
+        }
+      }
+    });
+    Report("list_push_pop_logging", "capacity=" + std::to_string(kCapacity),
+           static_cast<double>(kEvents), seconds);
+  }
+
+  {
+    BoundedList<Event> lst(kCapacity);
+    double seconds = MeasureSeconds([&lst] {
+      for (size_t i = 0; i < kEvents; ++i) {
+        lst.push_back(Event{i, static_cast<uint32_t>(i & 7), 0});
+      }
+    });
+    Report("bounded_ring_logging", "capacity=" + std::to_string(kCapacity),
+           static_cast<double>(kEvents), seconds);
+  }
+}
+
+template <typename L>
+void FifoPolicyWorkload(const std::string& name, size_t node_bytes) {
+  constexpr size_t kDepth = 1024;
+  constexpr size_t kOps = 20'000'000;
+
+  L lst;
+  for (size_t i = 0; i < kDepth; ++i) {
+    lst.push_back(static_cast<int>(i));
+  }
+
+  long long sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < kOps; ++i) {
+      sum += lst.front();
+      lst.pop_front();
+      lst.push_back(static_cast<int>(i));
+    }
+  });
+
+  std::cout << name << " node=" << node_bytes << "B list=" << sizeof(L)
+            << "B (checksum " << sum % 10 << ")\n";
+  Report(name, "fifo depth=" + std::to_string(kDepth),
+         static_cast<double>(kOps), seconds);
+}
+
+void BENCH_POLICIES() {
+  FifoPolicyWorkload<List<int>>("double_tracked", sizeof(Node<int>));
+  FifoPolicyWorkload<
+      List<int, std::allocator<int>, Links::Double, Size::Untracked>>(
+      "double_untracked", sizeof(Node<int>));
+  FifoPolicyWorkload<List<int, std::allocator<int>, Links::Single>>(
+      "single_tracked", sizeof(ForwardNode<int>));
+  FifoPolicyWorkload<
+      List<int, std::allocator<int>, Links::Single, Size::Untracked>>(
+      "single_untracked", sizeof(ForwardNode<int>));
+}
+
+template <typename L, typename NodeType>
+void TraversalLayoutWorkload(const std::string& name) {
+  constexpr size_t kElements = 10'000'000;
+  constexpr int kPasses = 5;
+
+  L lst;
+  for (size_t i = 0; i < kElements; ++i) {
+    lst.push_back(static_cast<int64_t>(i));
+  }
+
+  void* probe = std::malloc(sizeof(NodeType));
+  size_t usable = malloc_usable_size(probe);
+  std::free(probe);
+
+  int64_t sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (auto it = lst.begin(); it != lst.end(); ++it) {
+        sum += *it;
+      }
+      for (auto it = lst.rbegin(); it != lst.rend(); ++it) {
+        sum -= *it;
+      }
+    }
+  });
+
+  std::cout << name << " node=" << sizeof(NodeType)
+            << "B malloc_chunk=" << usable << "B links="
+            << sizeof(NodeType) - sizeof(int64_t) << "B (checksum " << sum
+            << ")\n";
+  Report(name, "traversal n=" + std::to_string(kElements),
+         static_cast<double>(kElements * kPasses * 2), seconds);
+}
+
+void BENCH_XOR() {
+  TraversalLayoutWorkload<List<int64_t>, Node<int64_t>>("two_pointer_links");
+  TraversalLayoutWorkload<List<int64_t, std::allocator<int64_t>, Links::Xor>,
+                          XorNode<int64_t>>("xor_links");
+}
+
+// One "request": build a few lists, work with them, drop them all.
+template <typename L, typename MakeList>
+int64_t RequestWorkload(MakeList make_list) {
+  constexpr int kLists = 8;
+  constexpr int kElements = 256;
+
+  int64_t sum = 0;
+  std::vector<L> lists;
+  lists.reserve(kLists);
+  for (int i = 0; i < kLists; ++i) {
+    lists.push_back(make_list());
+    for (int j = 0; j < kElements; ++j) {
+      lists.back().push_back(j);
+    }
+  }
+  for (auto& lst : lists) {
+    lst.pop_front();
+    for (int x : lst) {
+      sum += x;
+    }
+  }
+  return sum;
+}
+
+void BENCH_PMR() {
+  constexpr size_t kRequests = 50'000;
+  constexpr double kNodesPerRequest = 8 * 256;
+  int64_t sum = 0;
+
+  double seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < kRequests; ++i) {
+      sum += RequestWorkload<List<int>>([] { return List<int>(); });
+    }
+  });
+  Report("std_allocator_request", "nodes", kRequests * kNodesPerRequest,
+         seconds);
+
+  seconds = MeasureSeconds([&] {
+    std::vector<std::byte> buffer(1 << 20);
+    for (size_t i = 0; i < kRequests; ++i) {
+      std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+      sum += RequestWorkload<pmr::List<int>>(
+          [&arena] { return pmr::List<int>(&arena); });
+    }
+  });
+  Report("pmr_monotonic_request", "nodes", kRequests * kNodesPerRequest,
+         seconds);
+
+  seconds = MeasureSeconds([&] {
+    std::pmr::unsynchronized_pool_resource pool;
+    for (size_t i = 0; i < kRequests; ++i) {
+      sum += RequestWorkload<pmr::List<int>>(
+          [&pool] { return pmr::List<int>(&pool); });
+    }
+  });
+  Report("pmr_pool_request", "nodes", kRequests * kNodesPerRequest, seconds);
+
+  std::cout << "checksum " << sum % 10 << "\n";
+}
+
+void BENCH_RANGES() {
+  constexpr int kElements = 1'000'000;
+  constexpr int kRounds = 20;
+
+  List<int> source;
+  for (int i = 0; i < kElements; ++i) {
+    source.push_back(i);
+  }
+
+  auto keep = [](int x) { return x % 3 != 0; };
+  auto scale = [](int x) { return x * 7; };
+  constexpr size_t kTake = kElements / 2;
+
+  int64_t sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int round = 0; round < kRounds; ++round) {
+      List<int> filtered;
+      for (int x : source) {
+        if (keep(x)) {
+          filtered.push_back(x);
+        }
+      }
+      List<int> transformed;
+      for (int x : filtered) {
+        transformed.push_back(scale(x));
+      }
+      List<int> taken;
+      for (int x : transformed) {
+        if (taken.size() == kTake) {
+          break;
+        }
+        taken.push_back(x);
+      }
+      for (int x : taken) {
+        sum += x;
+      }
+    }
+  });
+  Report("materialized_pipeline", "n=" + std::to_string(kElements),
+         static_cast<double>(kElements) * kRounds, seconds);
+
+  seconds = MeasureSeconds([&] {
+    for (int round = 0; round < kRounds; ++round) {
+      for (int x : source | std::views::filter(keep) |
+                       std::views::transform(scale) |
+                       std::views::take(kTake)) {
+        sum -= x;
+      }
+    }
+  });
+  Report("lazy_views_pipeline", "n=" + std::to_string(kElements),
+         static_cast<double>(kElements) * kRounds, seconds);
+
+  std::cout << "checksum " << sum << "\n";
+}
+
+// Keys drawn from a Zipf(s) distribution over [0, keys) by inverting its CDF.
+std::vector<int> ZipfTrace(size_t keys, double s, size_t length,
+                           unsigned seed) {
+  std::vector<double> cdf(keys);
+  double total = 0;
+  for (size_t i = 0; i < keys; ++i) {
+    total += 1.0 / std::pow(static_cast<double>(i + 1), s);
+    cdf[i] = total;
+  }
+
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> uniform(0, total);
+  std::vector<int> trace(length);
+  for (int& key : trace) {
+    key = static_cast<int>(
+        std::lower_bound(cdf.begin(), cdf.end(), uniform(gen)) - cdf.begin());
+  }
+  return trace;
+}
+
+// The usual map-plus-list cache: a hit moves the entry to the front by
+// erasing and re-pushing it, a miss pushes a new entry and drops the back.
+class MapListCache {
+ private:
+  using Entry = std::pair<int, int64_t>;
+
+  size_t capacity_;
+  List<Entry> recency_;
+  std::unordered_map<int, List<Entry>::iterator> index_;
+
+ public:
+  explicit MapListCache(size_t capacity) : capacity_(capacity) {
+    index_.reserve(capacity);
+  }
+
+  int64_t* get(int key) {
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      return nullptr;
+    }
+    Entry entry = *found->second;
+    recency_.erase(found->second);
+    recency_.push_front(entry);
+    found->second = recency_.begin();
+    return &recency_.front().second;
+  }
+
+  void put(int key, int64_t value) {
+    if (recency_.size() == capacity_) {
+      index_.erase(recency_.back().first);
+      recency_.pop_back();
+    }
+    recency_.push_front({key, value});
+    index_[key] = recency_.begin();
+  }
+};
+
+template <typename Cache>
+void ZipfCacheWorkload(const std::string& name, const std::vector<int>& trace,
+                       size_t capacity, double s) {
+  Cache cache(capacity);
+  size_t hits = 0;
+
+  double seconds = MeasureSeconds([&] {
+    for (int key : trace) {
+      if (int64_t* value = cache.get(key)) {
+        ++hits;
+        ++*value;
+      } else {
+        cache.put(key, key);
+      }
+    }
+  });
+
+  Report(name,
+         "s=" + std::to_string(s).substr(0, 4) +
+             " capacity=" + std::to_string(capacity) + " hit=" +
+             std::to_string(100 * hits / trace.size()) + "%",
+         static_cast<double>(trace.size()), seconds);
+}
+
+void BENCH_LRU() {
+  constexpr size_t kKeys = 1'000'000;
+  constexpr size_t kLength = 20'000'000;
+
+  for (double s : {0.8, 0.99, 1.2}) {
+    std::vector<int> trace = ZipfTrace(kKeys, s, kLength, 42);
+    for (size_t capacity : {1'000, 100'000}) {
+      ZipfCacheWorkload<MapListCache>("map_list_lru", trace, capacity, s);
+      ZipfCacheWorkload<LruCache<int, int64_t>>("pooled_flat_lru", trace,
+                                                capacity, s);
+    }
+  }
+}
+
+class MutexList {
+ private:
+  std::mutex mutex_;
+  List<int64_t> list_;
+
+ public:
+  void push_back(int64_t val) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    list_.push_back(val);
+  }
+
+  void drain_into(List<int64_t>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.append(std::move(list_));
+  }
+};
+
+template <typename L>
+void ConcurrentAppendWorkload(const std::string& name, size_t threads) {
+  constexpr size_t kTotal = 8'000'000;
+  size_t per_thread = kTotal / threads;
+
+  L lst;
+  double seconds = RunThreads(threads, [&lst, per_thread](size_t t) {
+    for (size_t i = 0; i < per_thread; ++i) {
+      lst.push_back(static_cast<int64_t>(t * per_thread + i));
+    }
+  });
+
+  List<int64_t> out;
+  double drain = MeasureSeconds([&] { lst.drain_into(out); });
+
+  Report(name,
+         "threads=" + std::to_string(threads) +
+             " drain=" + std::to_string(drain * 1e6).substr(0, 6) + "us",
+         static_cast<double>(per_thread * threads), seconds);
+}
+
+void BENCH_SHARDED() {
+  for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+    ConcurrentAppendWorkload<MutexList>("mutex_list_append", threads);
+    ConcurrentAppendWorkload<ShardedList<int64_t>>("sharded_list_append",
+                                                   threads);
+  }
+}
+
+// Builds a list whose nodes sit in random order over the arena: nodes of a
+// scratch list are freed in shuffled order, and the arena's LIFO free lists
+// hand them out again in that order.
+template <typename L>
+void BuildScattered(L& lst, size_t count) {
+  L scratch(lst.get_allocator());
+  std::vector<typename L::iterator> nodes;
+  nodes.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    scratch.push_back(0);
+    nodes.push_back(std::prev(scratch.end()));
+  }
+
+  std::shuffle(nodes.begin(), nodes.end(), std::mt19937(3));
+  for (auto it : nodes) {
+    scratch.erase(it);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    lst.push_back(static_cast<int64_t>(i));
+  }
+}
+
+void HugePageTraversal(const std::string& name, HugePageOptions options) {
+  constexpr size_t kElements = 4'000'000;
+  constexpr int kPasses = 5;
+
+  HugePageAllocator<int64_t> alloc(options);
+  List<int64_t, HugePageAllocator<int64_t>> lst(alloc);
+  BuildScattered(lst, kElements);
+
+  int64_t sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (int64_t x : lst) {
+        sum += x;
+      }
+    }
+  });
+
+  const HugePageArena& arena = alloc.arena();
+  std::cout << name << " slabs hugetlb="
+            << arena.slab_count(HugePageArena::Backing::Hugetlb)
+            << " thp=" << arena.slab_count(HugePageArena::Backing::Transparent)
+            << " regular=" << arena.slab_count(HugePageArena::Backing::Regular)
+            << " (checksum " << sum % 10 << ")\n";
+  Report(name, "scattered traversal n=" + std::to_string(kElements),
+         static_cast<double>(kElements * kPasses), seconds);
+}
+
+void BENCH_HUGE_PAGES() {
+  HugePageTraversal("pages_4k", HugePageOptions{false, false});
+  HugePageTraversal("pages_2m", HugePageOptions{true, false});
+  HugePageTraversal("pages_2m_local_node", HugePageOptions{true, true});
+}
+
+int64_t TraversalSum(const List<int64_t>& lst, int passes) {
+  int64_t sum = 0;
+  for (int pass = 0; pass < passes; ++pass) {
+    for (int64_t x : lst) {
+      sum += x;
+    }
+  }
+  return sum;
+}
+
+void BENCH_COMPACT() {
+  constexpr size_t kElements = 4'000'000;
+  constexpr int kPasses = 5;
+  constexpr size_t kBudget = 4096;
+  int64_t sum = 0;
+
+  for (int mode = 0; mode < 2; ++mode) {
+    List<int64_t> lst;
+    BuildScattered(lst, kElements);
+
+    double seconds = MeasureSeconds([&] { sum += TraversalSum(lst, kPasses); });
+    Report("fragmented_traversal", "n=" + std::to_string(kElements),
+           static_cast<double>(kElements * kPasses), seconds);
+
+    std::string name;
+    double compact_seconds = 0;
+    if (mode == 0) {
+      name = "compacted_traversal";
+      compact_seconds = MeasureSeconds([&] { lst.compact(); });
+    } else {
+      name = "incrementally_compacted_traversal";
+      compact_seconds = MeasureSeconds([&] {
+        List<int64_t>::Cursor cursor(lst);
+        while (lst.compact(cursor, kBudget) == kBudget) {
+        }
+      });
+    }
+
+    seconds = MeasureSeconds([&] { sum += TraversalSum(lst, kPasses); });
+    Report(name,
+           "n=" + std::to_string(kElements) +
+               " compact=" + std::to_string(compact_seconds).substr(0, 5) +
+               "s",
+           static_cast<double>(kElements * kPasses), seconds);
+  }
+
+  std::cout << "checksum " << sum % 10 << "\n";
+}
+
+class SharedMutexList {
+ private:
+  std::shared_mutex mutex_;
+  List<int64_t> list_;
+
+ public:
+  class Reader {
+   private:
+    SharedMutexList* list_;
+
+   public:
+    explicit Reader(SharedMutexList& list) : list_(&list) {}
+
+    template <typename F>
+    void for_each(F func) {
+      std::shared_lock<std::shared_mutex> lock(list_->mutex_);
+      for (int64_t x : list_->list_) {
+        func(x);
+      }
+    }
+  };
+
+  void push_back(int64_t val) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    list_.push_back(val);
+  }
+
+  void pop_front() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    list_.pop_front();
+  }
+};
+
+// One writer rotates the list while readers sum it over and over.
+template <typename L>
+void ReadMostlyWorkload(const std::string& name, size_t readers) {
+  constexpr int64_t kLength = 256;
+  constexpr auto kDuration = std::chrono::milliseconds(500);
+
+  L lst;
+  for (int64_t i = 0; i < kLength; ++i) {
+    lst.push_back(i);
+  }
+
+  // Everybody watches the clock: a reader-preferring rwlock can starve the
+  // writer for the whole run.
+  auto stop = BenchClock::now() + kDuration;
+  std::atomic<size_t> traversals = 0;
+  size_t writes = 0;
+
+  double seconds = RunThreads(readers + 1, [&](size_t t) {
+    if (t == 0) {
+      for (int64_t i = kLength; BenchClock::now() < stop; ++i) {
+        lst.push_back(i);
+        lst.pop_front();
+        ++writes;
+      }
+      return;
+    }
+
+    typename L::Reader reader(lst);
+    size_t local = 0;
+    int64_t sum = 0;
+    while (BenchClock::now() < stop) {
+      reader.for_each([&sum](int64_t x) { sum += x; });
+      ++local;
+    }
+    traversals += local + (sum == 42 ? 1 : 0);
+  });
+
+  Report(name + "_reads", "readers=" + std::to_string(readers),
+         static_cast<double>(traversals.load() * kLength), seconds);
+  Report(name + "_writes", "readers=" + std::to_string(readers),
+         static_cast<double>(writes), seconds);
+}
+
+void BENCH_RCU() {
+  for (size_t readers : {1, 2, 4, 8}) {
+    ReadMostlyWorkload<SharedMutexList>("shared_mutex", readers);
+    ReadMostlyWorkload<RcuList<int64_t>>("rcu", readers);
+  }
+}
+
+DetachedTask BenchEcho(AsyncChannel<int64_t>& in, AsyncChannel<int64_t>& out) {
+  while (std::optional<int64_t> val = co_await in.pop()) {
+    co_await out.push(*val);
+  }
+}
+
+DetachedTask BenchPinger(AsyncChannel<int64_t>& out, AsyncChannel<int64_t>& in,
+                         size_t rounds, int64_t& sum) {
+  for (size_t i = 0; i < rounds; ++i) {
+    co_await out.push(static_cast<int64_t>(i));
+    sum += *co_await in.pop();
+  }
+  out.close();
+}
+
+DetachedTask BenchProducer(AsyncChannel<int64_t>& out, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    co_await out.push(static_cast<int64_t>(i));
+  }
+}
+
+DetachedTask BenchConsumer(AsyncChannel<int64_t>& in, int64_t& sum) {
+  while (std::optional<int64_t> val = co_await in.pop()) {
+    sum += *val;
+  }
+}
+
+void BENCH_ASYNC_CHANNEL() {
+  constexpr size_t kRounds = 5'000'000;
+  int64_t sum = 0;
+
+  {
+    AsyncChannel<int64_t> ping;
+    AsyncChannel<int64_t> pong;
+    double seconds = MeasureSeconds([&] {
+      BenchEcho(ping, pong);
+      BenchPinger(ping, pong, kRounds, sum);
+    });
+    std::cout << "channel_ping_pong round_trip=" << seconds / kRounds * 1e9
+              << " ns\n";
+    Report("channel_ping_pong", "rounds", static_cast<double>(kRounds),
+           seconds);
+  }
+
+  for (size_t capacity :
+       {size_t(1), size_t(64), AsyncChannel<int64_t>::kUnbounded}) {
+    for (size_t producers : {1, 16, 256}) {
+      size_t per_producer = kRounds / producers;
+      AsyncChannel<int64_t> channel(capacity);
+      // Producers start first, so they fill the buffer and then block on it
+      // until the consumer drains it.
+      double seconds = MeasureSeconds([&] {
+        for (size_t p = 0; p < producers; ++p) {
+          BenchProducer(channel, per_producer);
+        }
+        BenchConsumer(channel, sum);
+        channel.close();
+      });
+      Report("channel_fan_in",
+             "producers=" + std::to_string(producers) + " capacity=" +
+                 (capacity == AsyncChannel<int64_t>::kUnbounded
+                      ? std::string("unbounded")
+                      : std::to_string(capacity)),
+             static_cast<double>(per_producer * producers), seconds);
+    }
+  }
+
+  std::cout << "checksum " << sum % 10 << "\n";
+}
+
+// Timer-heavy server loop: 1e5 connections keep re-arming or cancelling
+// their timeouts, and the clock moves one tick every 10 operations.
+struct TimerOp {
+  uint32_t timer;
+  uint32_t timeout;  // 0 means cancel.
+};
+
+std::vector<TimerOp> TimerTrace(size_t timers, size_t ops) {
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<uint32_t> pick(0, timers - 1);
+  std::uniform_int_distribution<uint32_t> timeout(1, 1 << 16);
+  std::vector<TimerOp> trace(ops);
+  for (TimerOp& op : trace) {
+    op.timer = pick(gen);
+    op.timeout = gen() % 4 == 0 ? 0 : timeout(gen);
+  }
+  return trace;
+}
+
+void BENCH_TIMER_WHEEL() {
+  constexpr size_t kTimers = 100'000;
+  constexpr size_t kOps = 10'000'000;
+  std::vector<TimerOp> trace = TimerTrace(kTimers, kOps);
+  size_t expired = 0;
+
+  {
+    using Map = std::multimap<uint64_t, uint32_t>;
+    Map timers;
+    std::vector<Map::iterator> handles(kTimers, timers.end());
+    uint64_t now = 0;
+
+    double seconds = MeasureSeconds([&] {
+      for (size_t i = 0; i < kOps; ++i) {
+        const TimerOp& op = trace[i];
+        if (handles[op.timer] != timers.end()) {
+          timers.erase(handles[op.timer]);
+          handles[op.timer] = timers.end();
+        }
+        if (op.timeout != 0) {
+          handles[op.timer] = timers.emplace(now + op.timeout, op.timer);
+        }
+        if (i % 10 == 9) {
+          ++now;
+          while (!timers.empty() && timers.begin()->first <= now) {
+            handles[timers.begin()->second] = timers.end();
+            timers.erase(timers.begin());
+            ++expired;
+          }
+        }
+      }
+    });
+    Report("multimap_timers", "timers=" + std::to_string(kTimers),
+           static_cast<double>(kOps), seconds);
+  }
+
+  {
+    TimerWheel wheel;
+    std::vector<Timer> timers(kTimers);
+
+    double seconds = MeasureSeconds([&] {
+      for (size_t i = 0; i < kOps; ++i) {
+        const TimerOp& op = trace[i];
+        if (op.timeout != 0) {
+          wheel.schedule(timers[op.timer], wheel.now() + op.timeout);
+        } else {
+          wheel.cancel(timers[op.timer]);
+        }
+        if (i % 10 == 9) {
+          wheel.advance(wheel.now() + 1, [&expired](Timer&) { ++expired; });
+        }
+      }
+    });
+    Report("timer_wheel", "timers=" + std::to_string(kTimers),
+           static_cast<double>(kOps), seconds);
+  }
+
+  std::cout << "expired " << expired << "\n";
+}
+
+template <size_t Bytes>
+struct Payload {
+  std::array<char, Bytes> bytes{};
+};
+
+template <size_t Bytes>
+void ParallelCopyWorkload(size_t elements) {
+  List<Payload<Bytes>> source(elements);
+
+  double seconds = MeasureSeconds([&] { List<Payload<Bytes>> copy(source); });
+  Report("serial_copy", "bytes=" + std::to_string(Bytes),
+         static_cast<double>(elements), seconds);
+
+  for (size_t threads : {2, 4, 8}) {
+    ThreadExecutor executor(threads);
+    seconds = MeasureSeconds([&] {
+      auto copy = List<Payload<Bytes>>::parallel_copy(source, executor);
+    });
+    Report("parallel_copy",
+           "bytes=" + std::to_string(Bytes) +
+               " threads=" + std::to_string(threads),
+           static_cast<double>(elements), seconds);
+  }
+}
+
+void BENCH_PARALLEL_COPY() {
+  ParallelCopyWorkload<8>(4'000'000);
+  ParallelCopyWorkload<64>(2'000'000);
+  ParallelCopyWorkload<1024>(200'000);
+}
+
+template <typename L>
+int64_t RangeSum(const L& lst, int passes) {
+  int64_t sum = 0;
+  for (int pass = 0; pass < passes; ++pass) {
+    for (int64_t x : lst) {
+      sum += x;
+    }
+  }
+  return sum;
+}
+
+// Built by push_back, then only read.
+void BuildThenScan(size_t elements, int passes) {
+  const std::string params =
+      "n=" + std::to_string(elements) + " passes=" + std::to_string(passes);
+  const double scanned = static_cast<double>(elements) * passes;
+  int64_t sum = 0;
+
+  {
+    std::vector<int64_t> vec;
+    for (size_t i = 0; i < elements; ++i) {
+      vec.push_back(static_cast<int64_t>(i));
+    }
+    Report("scan_vector", params, scanned,
+           MeasureSeconds([&] { sum += RangeSum(vec, passes); }));
+  }
+  {
+    List<int64_t> lst;
+    BuildScattered(lst, elements);
+    Report("scan_list", params, scanned,
+           MeasureSeconds([&] { sum += RangeSum(lst, passes); }));
+  }
+  {
+    AdaptiveList<int64_t> lst;
+    BuildScattered(lst, elements);
+    Report("scan_adaptive", params, scanned,
+           MeasureSeconds([&] { sum += RangeSum(lst, passes); }));
+    Report("scan_adaptive_frozen", params, scanned,
+           MeasureSeconds([&] { sum += RangeSum(lst, passes); }));
+  }
+  {
+    AdaptiveList<int64_t> lst;
+    BuildScattered(lst, elements);
+    Report("scan_adaptive_for_each", params, scanned, MeasureSeconds([&] {
+             for (int pass = 0; pass < passes; ++pass) {
+               lst.for_each([&sum](int64_t x) { sum += x; });
+             }
+           }));
+  }
+
+  std::cout << "checksum " << sum % 10 << "\n";
+}
+
+// Rounds of one push_back/pop_front pair followed by scans_per_mutation
+// full scans.
+template <typename L>
+void MixedScan(const std::string& name, size_t elements,
+               int scans_per_mutation, size_t rounds) {
+  L lst;
+  BuildScattered(lst, elements);
+  int64_t sum = 0;
+  int64_t next = static_cast<int64_t>(elements);
+
+  double seconds = MeasureSeconds([&] {
+    for (size_t round = 0; round < rounds; ++round) {
+      lst.push_back(next++);
+      lst.pop_front();
+      sum += RangeSum(lst, scans_per_mutation);
+    }
+  });
+
+  Report(name,
+         "n=" + std::to_string(elements) +
+             " scans/mutation=" + std::to_string(scans_per_mutation),
+         static_cast<double>(elements * rounds * scans_per_mutation),
+         seconds);
+  std::cout << "checksum " << sum % 10 << "\n";
+}
+
+void BENCH_ADAPTIVE() {
+  BuildThenScan(1'000'000, 20);
+
+  for (int scans : {1, 4, 16, 64}) {
+    size_t rounds = 256 / scans;
+    MixedScan<List<int64_t>>("mixed_list", 100'000, scans, rounds);
+    MixedScan<AdaptiveList<int64_t>>("mixed_adaptive", 100'000, scans,
+                                     rounds);
+  }
+}
+
+// Nearest-rank percentile of samples, which gets sorted.
+double Percentile(std::vector<double>& samples, double fraction) {
+  std::sort(samples.begin(), samples.end());
+  size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+  return samples[std::max<size_t>(rank, 1) - 1];
+}
+
+// Requests that each build a list and drop it, with idle time in between
+// as if waiting for the next request; only the drop is timed.
+void DropLatency(const std::string& name, DeferredReclaimer* reclaimer,
+                 size_t elements, size_t requests,
+                 std::chrono::microseconds idle) {
+  std::vector<double> drops;
+  drops.reserve(requests);
+
+  double total = MeasureSeconds([&] {
+    for (size_t i = 0; i < requests; ++i) {
+      auto* lst = new DeferredList<int64_t>();
+      lst->set_reclaimer(reclaimer);
+      for (size_t j = 0; j < elements; ++j) {
+        lst->push_back(static_cast<int64_t>(j));
+      }
+      drops.push_back(MeasureSeconds([&] { delete lst; }));
+      std::this_thread::sleep_for(idle);
+    }
+    if (reclaimer != nullptr) {
+      reclaimer->flush();
+    }
+  });
+
+  double p50 = Percentile(drops, 0.5);
+  double p99 = Percentile(drops, 0.99);
+  std::cout << name << " n=" << elements << " requests=" << requests
+            << " idle=" << idle.count() << "us: drop p50=" << p50 * 1e6
+            << "us p99=" << p99 * 1e6 << "us max=" << drops.back() * 1e6
+            << "us (total " << total << " s)\n";
+}
+
+void BENCH_DEFERRED() {
+  using std::chrono::microseconds;
+  const std::pair<size_t, size_t> kRuns[] = {
+      {10'000, 400}, {1'000'000, 20}, {10'000'000, 8}};
+  for (auto [elements, requests] : kRuns) {
+    microseconds idle(elements / 20);
+    DropLatency("drop_inline", nullptr, elements, requests, idle);
+    DeferredReclaimer reclaimer;
+    DropLatency("drop_deferred", &reclaimer, elements, requests, idle);
+  }
+}
+
+// Queue-style churn: keeps a window of live elements and pushes and pops
+// through it, so every push allocates and every pop frees.
+template <typename Alloc>
+void PushPopChurn(const std::string& name, const Alloc& alloc) {
+  constexpr size_t kOps = 20'000'000;
+  constexpr size_t kWindow = 1024;
+
+  List<int64_t, Alloc> lst(alloc);
+  for (size_t i = 0; i < kWindow; ++i) {
+    lst.push_back(static_cast<int64_t>(i));
+  }
+  int64_t sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < kOps; ++i) {
+      lst.push_back(static_cast<int64_t>(i));
+      sum += lst.front();
+      lst.pop_front();
+    }
+  });
+  Report(name, "push+pop window=" + std::to_string(kWindow) + " (checksum " +
+                   std::to_string(sum % 10) + ")",
+         static_cast<double>(kOps), seconds);
+}
+
+void BENCH_PROFILING() {
+  PushPopChurn("std_allocator", std::allocator<int64_t>());
+
+  const uint32_t kRates[] = {0, 1024, 64, 1};
+  for (uint32_t rate : kRates) {
+    ProfileOptions options;
+    options.sample_every = rate;
+    auto profile = std::make_shared<AllocationProfile>(options);
+    PushPopChurn("profiling sample_every=" + std::to_string(rate),
+                 ProfilingAllocator<int64_t>(profile, "churn"));
+    profile->dump(std::cout);
+  }
+}
+
+int main() {
+  BENCH_CONCURRENT_LIST();
+  BENCH_BATCH();
+  BENCH_BOUNDED();
+  BENCH_POLICIES();
+  BENCH_XOR();
+  BENCH_PMR();
+  BENCH_RANGES();
+  BENCH_LRU();
+  BENCH_SHARDED();
+  BENCH_HUGE_PAGES();
+  BENCH_COMPACT();
+  BENCH_RCU();
+  BENCH_ASYNC_CHANNEL();
+  BENCH_TIMER_WHEEL();
+  BENCH_PARALLEL_COPY();
+  BENCH_ADAPTIVE();
+  BENCH_DEFERRED();
+  BENCH_PROFILING();
+}
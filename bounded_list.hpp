@@ -0,0 +1,227 @@
+#pragma once
+
+#include <memory>
+
+#include "list.hpp"
+
+// Capacity-capped list. All nodes are carved from one block allocated in the
+// constructor; unused nodes wait unconstructed on a free stack. Pushing into
+// a full list overwrites the oldest element in place and relinks its node to
+// the other end, so no allocator calls happen after construction. Iterators
+// are the ones of List<T, Alloc>.
+template <typename T, typename Alloc = std::allocator<T>>
+class BoundedList {
+ private:
+  TruncatedNode initial_node_;
+  TruncatedNode* free_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+
+  Alloc list_alloc_;
+  using alloc_traits = std::allocator_traits<Alloc>;
+  typename alloc_traits::template rebind_alloc<Node<T>> node_alloc_;
+  using node_alloc_traits =
+      typename alloc_traits::template rebind_traits<Node<T>>;
+
+  Node<T>* nodes_ = nullptr;
+
+  static Node<T>* as_node(TruncatedNode* node) {
+    return static_cast<Node<T>*>(node);
+  }
+
+  void link_back(TruncatedNode* node) {
+    TruncatedNode::link_before(&initial_node_, node);
+  }
+
+  void link_front(TruncatedNode* node) {
+    TruncatedNode::link_before(initial_node_.next, node);
+  }
+
+  // A free slot holds a bare TruncatedNode constructed in the node's
+  // storage, so the free stack never writes through a dead Node.
+  void push_free(Node<T>* storage) {
+    free_ = std::construct_at(
+        static_cast<TruncatedNode*>(static_cast<void*>(storage)), free_,
+        nullptr);
+  }
+
+  Node<T>* pop_free() {
+    TruncatedNode* slot = free_;
+    free_ = slot->next;
+    std::destroy_at(slot);
+    return static_cast<Node<T>*>(static_cast<void*>(slot));
+  }
+
+  void release(TruncatedNode* node) {
+    Node<T>* storage = as_node(node);
+    node_alloc_traits::destroy(node_alloc_, storage);
+    push_free(storage);
+  }
+
+  template <typename U>
+  TruncatedNode* acquire(U&& val) {
+    Node<T>* storage = pop_free();
+
+    try {
+      node_alloc_traits::construct(node_alloc_, storage, std::forward<U>(val));
+    } catch (...) {
+      push_free(storage);
+      throw;
+    }
+
+    return storage;
+  }
+
+  template <typename U>
+  void push_back_impl(U&& val) {
+    if (capacity_ == 0) {
+      return;
+    }
+
+    if (size_ < capacity_) {
+      link_back(acquire(std::forward<U>(val)));
+      size_++;
+      return;
+    }
+
+    TruncatedNode* oldest = initial_node_.next;
+    as_node(oldest)->get_val() = std::forward<U>(val);
+    TruncatedNode::unlink(oldest);
+    link_back(oldest);
+  }
+
+  template <typename U>
+  void push_front_impl(U&& val) {
+    if (capacity_ == 0) {
+      return;
+    }
+
+    if (size_ < capacity_) {
+      link_front(acquire(std::forward<U>(val)));
+      size_++;
+      return;
+    }
+
+    TruncatedNode* newest = initial_node_.prev;
+    as_node(newest)->get_val() = std::forward<U>(val);
+    TruncatedNode::unlink(newest);
+    link_front(newest);
+  }
+
+ public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using iterator = typename List<T, Alloc>::iterator;
+  using const_iterator = typename List<T, Alloc>::const_iterator;
+  using reverse_iterator = typename List<T, Alloc>::reverse_iterator;
+  using const_reverse_iterator =
+      typename List<T, Alloc>::const_reverse_iterator;
+
+  explicit BoundedList(size_t capacity, const Alloc& alloc = Alloc())
+      : capacity_(capacity), list_alloc_(alloc), node_alloc_(alloc) {
+    if (capacity_ == 0) {
+      return;
+    }
+
+    nodes_ = node_alloc_traits::allocate(node_alloc_, capacity_);
+
+    for (size_t i = capacity_; i > 0; i--) {
+      push_free(nodes_ + (i - 1));
+    }
+  }
+
+  BoundedList(const BoundedList& other)
+      : BoundedList(other.capacity_,
+                    alloc_traits::select_on_container_copy_construction(
+                        other.list_alloc_)) {
+    for (const T& val : other) {
+      push_back(val);
+    }
+  }
+
+  BoundedList& operator=(const BoundedList&) = delete;
+
+  ~BoundedList() {
+    clear();
+
+    if (nodes_ != nullptr) {
+      node_alloc_traits::deallocate(node_alloc_, nodes_, capacity_);
+    }
+  }
+
+  size_t size() const { return size_; }
+
+  size_t capacity() const { return capacity_; }
+
+  bool empty() const { return size_ == 0; }
+
+  bool full() const { return size_ == capacity_; }
+
+  Alloc get_allocator() const { return list_alloc_; }
+
+  T& front() { return as_node(initial_node_.next)->get_val(); }
+
+  const T& front() const { return as_node(initial_node_.next)->get_val(); }
+
+  T& back() { return as_node(initial_node_.prev)->get_val(); }
+
+  const T& back() const { return as_node(initial_node_.prev)->get_val(); }
+
+  void push_back(const T& val) { push_back_impl(val); }
+
+  void push_back(T&& val) { push_back_impl(std::move(val)); }
+
+  void push_front(const T& val) { push_front_impl(val); }
+
+  void push_front(T&& val) { push_front_impl(std::move(val)); }
+
+  void pop_back() noexcept {
+    TruncatedNode* node = initial_node_.prev;
+    TruncatedNode::unlink(node);
+    release(node);
+    size_--;
+  }
+
+  void pop_front() noexcept {
+    TruncatedNode* node = initial_node_.next;
+    TruncatedNode::unlink(node);
+    release(node);
+    size_--;
+  }
+
+  void clear() noexcept {
+    while (size_ != 0) {
+      pop_back();
+    }
+  }
+
+  iterator begin() { return iterator(initial_node_.next); }
+
+  iterator end() { return iterator(&initial_node_); }
+
+  const_iterator begin() const { return const_iterator(initial_node_.next); }
+
+  const_iterator end() const {
+    return const_iterator(const_cast<TruncatedNode*>(&initial_node_));
+  }
+
+  const_iterator cbegin() const { return begin(); }
+
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return reverse_iterator(initial_node_.prev); }
+
+  reverse_iterator rend() { return reverse_iterator(&initial_node_); }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(initial_node_.prev);
+  }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(const_cast<TruncatedNode*>(&initial_node_));
+  }
+
+  const_reverse_iterator crbegin() const { return rbegin(); }
+
+  const_reverse_iterator crend() const { return rend(); }
+};
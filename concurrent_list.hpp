@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include "list.hpp"
+
+class LockableTruncatedNode : public TruncatedNode {
+ public:
+  std::mutex mutex;
+
+  LockableTruncatedNode() : TruncatedNode() {}
+
+  LockableTruncatedNode(const LockableTruncatedNode&) = delete;
+  LockableTruncatedNode& operator=(const LockableTruncatedNode&) = delete;
+
+  ~LockableTruncatedNode() = default;
+};
+
+template <typename T>
+class LockableNode : public LockableTruncatedNode {
+ private:
+  T val_;
+
+ public:
+  LockableNode(const T& val) : LockableTruncatedNode(), val_(val) {}
+
+  ~LockableNode() = default;
+
+  T& get_val() { return val_; }
+};
+
+// Sorted set on TruncatedNode links with hand-over-hand (lock coupling)
+// locking. Locks are always taken in list order starting from the sentinel,
+// which is never re-locked as the tail, so traversals cannot deadlock. A
+// node's prev pointer is only written while its predecessor is locked.
+// The allocator is shared between threads and has to be thread-safe.
+template <typename T, typename Compare = std::less<T>,
+          typename Alloc = std::allocator<T>>
+class ConcurrentSortedList {
+ private:
+  LockableTruncatedNode head_;
+  std::atomic<size_t> size_ = 0;
+
+  Compare comp_;
+
+  Alloc list_alloc_;
+  using alloc_traits = std::allocator_traits<Alloc>;
+  typename alloc_traits::template rebind_alloc<LockableNode<T>> node_alloc_;
+  using node_alloc_traits =
+      typename alloc_traits::template rebind_traits<LockableNode<T>>;
+
+  struct Window {
+    TruncatedNode* pred;
+    TruncatedNode* cur;
+    std::unique_lock<std::mutex> pred_lock;
+    std::unique_lock<std::mutex> cur_lock;
+  };
+
+  static std::mutex& mutex_of(TruncatedNode* node) {
+    return static_cast<LockableTruncatedNode*>(node)->mutex;
+  }
+
+  static T& value_of(TruncatedNode* node) {
+    return static_cast<LockableNode<T>*>(node)->get_val();
+  }
+
+  // Returns with pred and cur locked, where cur is the first node not less
+  // than val (or the sentinel, which stays unlocked).
+  Window find_window(const T& val) {
+    std::unique_lock<std::mutex> pred_lock(head_.mutex);
+    TruncatedNode* pred = &head_;
+    TruncatedNode* cur = head_.next;
+
+    while (cur != &head_) {
+      std::unique_lock<std::mutex> cur_lock(mutex_of(cur));
+      if (!comp_(value_of(cur), val)) {
+        return {pred, cur, std::move(pred_lock), std::move(cur_lock)};
+      }
+
+      pred_lock = std::move(cur_lock);
+      pred = cur;
+      cur = cur->next;
+    }
+
+    return {pred, cur, std::move(pred_lock), {}};
+  }
+
+  bool matches(const Window& window, const T& val) const {
+    return window.cur != &head_ && !comp_(val, value_of(window.cur));
+  }
+
+  void destroy_node(LockableNode<T>* node) {
+    node_alloc_traits::destroy(node_alloc_, node);
+    node_alloc_traits::deallocate(node_alloc_, node, 1);
+  }
+
+ public:
+  using value_type = T;
+  using allocator_type = Alloc;
+
+  ConcurrentSortedList(const Compare& comp = Compare(),
+                       const Alloc& alloc = Alloc())
+      : comp_(comp), list_alloc_(alloc), node_alloc_(alloc) {}
+
+  ConcurrentSortedList(const ConcurrentSortedList&) = delete;
+  ConcurrentSortedList& operator=(const ConcurrentSortedList&) = delete;
+
+  ~ConcurrentSortedList() {
+    TruncatedNode* cur = head_.next;
+
+    while (cur != &head_) {
+      TruncatedNode* next = cur->next;
+      destroy_node(static_cast<LockableNode<T>*>(cur));
+      cur = next;
+    }
+  }
+
+  // The node is built before any lock is taken to keep the critical section
+  // down to the traversal and the relink.
+  bool insert(const T& val) {
+    LockableNode<T>* node = node_alloc_traits::allocate(node_alloc_, 1);
+
+    try {
+      node_alloc_traits::construct(node_alloc_, node, val);
+    } catch (...) {
+      node_alloc_traits::deallocate(node_alloc_, node, 1);
+      throw;
+    }
+
+    Window window = find_window(val);
+
+    if (matches(window, val)) {
+      window.cur_lock.unlock();
+      window.pred_lock.unlock();
+      destroy_node(node);
+      return false;
+    }
+
+    TruncatedNode::link_before(window.cur, node);
+
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool erase(const T& val) {
+    Window window = find_window(val);
+
+    if (!matches(window, val)) {
+      return false;
+    }
+
+    TruncatedNode::unlink(window.cur);
+
+    // Nobody else can be waiting on cur: reaching it requires pred's lock.
+    window.cur_lock.unlock();
+    destroy_node(static_cast<LockableNode<T>*>(window.cur));
+
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool contains(const T& val) {
+    Window window = find_window(val);
+    return matches(window, val);
+  }
+
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  bool empty() const { return size() == 0; }
+
+  Alloc get_allocator() const { return list_alloc_; }
+
+  // Not synchronized with writers, meant for quiescent states only.
+  template <typename F>
+  void for_each(F func) {
+    for (TruncatedNode* cur = head_.next; cur != &head_; cur = cur->next) {
+      func(value_of(cur));
+    }
+  }
+};
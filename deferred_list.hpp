@@ -0,0 +1,270 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "list.hpp"
+
+struct DeferredReclaimerOptions {
+  // Elements that may wait for destruction at once. A list that would push
+  // the backlog past this is destroyed inline by whoever drops it.
+  size_t max_backlog = size_t(1) << 24;
+
+  // Run a reclaimer thread. Without one, call reclaim() at idle points.
+  bool background_thread = true;
+
+  // Run the thread under SCHED_IDLE, so that it only takes CPU time no
+  // other thread wants; a retire then never hands the core over to it. A
+  // busy machine can starve it, in which case the backlog fills up and
+  // drops go back to being inline.
+  bool idle_priority = true;
+};
+
+// Destroys dropped lists away from the thread that drops them. retire takes
+// a list over in O(1) by moving it into a queued job, a TruncatedNode in the
+// jobs_ ring; the reclaimer thread, or whoever calls reclaim(), then pops
+// its elements kBatch at a time with the lock released.
+//
+// The lists' allocators have to accept deallocation from the reclaiming
+// thread, and the reclaimer has to outlive every DeferredList using it. Its
+// destructor finishes the backlog.
+class DeferredReclaimer {
+ public:
+  static constexpr size_t kBatch = 4096;
+
+  explicit DeferredReclaimer(DeferredReclaimerOptions options = {})
+      : options_(options) {
+    if (options_.background_thread) {
+      worker_ = std::thread([this] { run(); });
+    }
+  }
+
+  DeferredReclaimer(const DeferredReclaimer&) = delete;
+  DeferredReclaimer& operator=(const DeferredReclaimer&) = delete;
+
+  ~DeferredReclaimer() {
+    if (worker_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+      }
+      work_ready_.notify_one();
+      worker_.join();
+    }
+    reclaim(static_cast<size_t>(-1));
+  }
+
+  // Queues the elements of list for destruction and leaves it empty.
+  // Returns false if they were destroyed inline because the backlog had no
+  // room. Throws only if allocating the job does, with list untouched.
+  template <typename T, typename Alloc, typename LinkPolicy>
+  bool retire(List<T, Alloc, LinkPolicy, Size::Tracked>&& list) {
+    using ListT = List<T, Alloc, LinkPolicy, Size::Tracked>;
+
+    size_t weight = list.size();
+    if (weight == 0) {
+      return true;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (backlog_ + weight > options_.max_backlog) {
+        weight = 0;
+      } else {
+        backlog_ += weight;
+      }
+    }
+    if (weight == 0) {
+      ListT doomed(std::move(list));
+      return false;
+    }
+
+    Job* job = nullptr;
+    try {
+      job = new ListJob<ListT>(std::move(list), weight);
+    } catch (...) {
+      finish(weight);
+      throw;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      TruncatedNode::link_before(&jobs_, job);
+    }
+    work_ready_.notify_one();
+    return true;
+  }
+
+  // Destroys up to about budget queued elements on the calling thread and
+  // returns how many it destroyed.
+  size_t reclaim(size_t budget) {
+    size_t done = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (done < budget && !jobs_.ring_empty()) {
+      Job* job = static_cast<Job*>(jobs_.next);
+      TruncatedNode::unlink(job);
+      lock.unlock();
+
+      size_t destroyed = job->destroy_some(std::min(kBatch, budget - done));
+      job->remaining -= destroyed;
+      done += destroyed;
+      bool finished = job->remaining == 0;
+      if (finished) {
+        delete job;
+      }
+
+      lock.lock();
+      if (!finished) {
+        TruncatedNode::link_before(jobs_.next, job);
+      }
+      if (release(destroyed)) {
+        drained_.notify_all();
+      }
+    }
+    return done;
+  }
+
+  // Blocks until every queued element has been destroyed. Without a
+  // reclaimer thread the calling thread does the work.
+  void flush() {
+    if (!worker_.joinable()) {
+      reclaim(static_cast<size_t>(-1));
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return backlog_ == 0; });
+  }
+
+  // Elements queued or being destroyed.
+  size_t backlog() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return backlog_;
+  }
+
+  size_t max_backlog() const { return options_.max_backlog; }
+
+ private:
+  struct Job : TruncatedNode {
+    size_t remaining;
+
+    explicit Job(size_t weight) : remaining(weight) {}
+
+    virtual ~Job() = default;
+
+    // Destroys up to budget elements, returns how many.
+    virtual size_t destroy_some(size_t budget) = 0;
+  };
+
+  template <typename ListT>
+  struct ListJob : Job {
+    ListT list;
+
+    ListJob(ListT&& from, size_t weight)
+        : Job(weight), list(std::move(from)) {}
+
+    size_t destroy_some(size_t budget) override {
+      size_t destroyed = 0;
+      for (; destroyed < budget && !list.empty(); destroyed++) {
+        list.pop_front();
+      }
+      return destroyed;
+    }
+  };
+
+  DeferredReclaimerOptions options_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_ready_;
+  std::condition_variable drained_;
+  TruncatedNode jobs_;
+  size_t backlog_ = 0;
+  bool stopping_ = false;
+  std::thread worker_;
+
+  // Takes weight off the backlog with the lock held, returns whether it
+  // ran dry.
+  bool release(size_t weight) {
+    backlog_ -= weight;
+    return weight != 0 && backlog_ == 0;
+  }
+
+  void finish(size_t weight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (release(weight)) {
+      drained_.notify_all();
+    }
+  }
+
+  void run() {
+    if (options_.idle_priority) {
+      sched_param param{};
+      pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      work_ready_.wait(lock,
+                       [this] { return stopping_ || !jobs_.ring_empty(); });
+      if (jobs_.ring_empty()) {
+        return;
+      }
+      lock.unlock();
+      reclaim(kBatch);
+      lock.lock();
+    }
+  }
+};
+
+// List whose destructor hands its nodes to a DeferredReclaimer instead of
+// destroying them inline. Without a reclaimer it is a plain List. Only
+// destruction is deferred: clear, erase and assignment stay inline. Copy
+// and move construction take the source's reclaimer; assignment keeps the
+// target's own. Not to be destroyed through a pointer to List.
+template <typename T, typename Alloc = std::allocator<T>,
+          typename LinkPolicy = Links::Double>
+class DeferredList : public List<T, Alloc, LinkPolicy, Size::Tracked> {
+ private:
+  using base = List<T, Alloc, LinkPolicy, Size::Tracked>;
+
+  DeferredReclaimer* reclaimer_ = nullptr;
+
+ public:
+  using base::base;
+
+  DeferredList() = default;
+
+  explicit DeferredList(DeferredReclaimer& reclaimer,
+                        const Alloc& alloc = Alloc())
+      : base(alloc), reclaimer_(&reclaimer) {}
+
+  DeferredList(const DeferredList&) = default;
+  DeferredList(DeferredList&&) noexcept = default;
+  DeferredList& operator=(const DeferredList& other) {
+    base::operator=(other);
+    return *this;
+  }
+
+  DeferredList& operator=(DeferredList&& other) {
+    base::operator=(std::move(other));
+    return *this;
+  }
+
+  // A failed hand-off leaves the elements to ~List.
+  ~DeferredList() {
+    if (reclaimer_ != nullptr) {
+      try {
+        reclaimer_->retire(std::move(static_cast<base&>(*this)));
+      } catch (...) {
+      }
+    }
+  }
+
+  DeferredReclaimer* reclaimer() const { return reclaimer_; }
+
+  void set_reclaimer(DeferredReclaimer* reclaimer) { reclaimer_ = reclaimer; }
+};
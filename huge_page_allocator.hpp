@@ -0,0 +1,234 @@
+#pragma once
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+struct HugePageOptions {
+  // Back slabs with 2 MiB pages: hugetlbfs pages when the kernel has some
+  // reserved, otherwise a 2 MiB aligned mapping advised for transparent huge
+  // pages. When false, slabs are advised to stay on regular pages.
+  bool huge_pages = true;
+
+  // Bind each slab to the NUMA node of the thread that triggered it.
+  bool bind_local_node = false;
+};
+
+// Slab arena behind HugePageAllocator. Requests up to kMaxClassBytes are
+// carved from 2 MiB slabs and recycled through per-size free lists, larger
+// or over-aligned ones go to operator new. Slabs are only returned to the
+// system when the arena dies. Not thread-safe, like
+// std::pmr::unsynchronized_pool_resource.
+class HugePageArena {
+ public:
+  static constexpr size_t kSlabBytes = size_t(2) << 20;
+  static constexpr size_t kGranule = 16;
+  static constexpr size_t kMaxClassBytes = 512;
+
+  enum class Backing { Hugetlb, Transparent, Regular };
+
+  explicit HugePageArena(HugePageOptions options = {}) : options_(options) {}
+
+  HugePageArena(const HugePageArena&) = delete;
+  HugePageArena& operator=(const HugePageArena&) = delete;
+
+  ~HugePageArena() {
+    for (const Slab& slab : slabs_) {
+      munmap(slab.base, kSlabBytes);
+    }
+  }
+
+  void* allocate(size_t bytes, size_t alignment) {
+    if (bytes > kMaxClassBytes || alignment > kGranule) {
+      return ::operator new(bytes, std::align_val_t{alignment});
+    }
+
+    FreeBlock*& head = free_lists_[class_of(bytes)];
+    if (head != nullptr) {
+      FreeBlock* block = head;
+      head = block->next;
+      return block;
+    }
+
+    size_t rounded = (class_of(bytes) + 1) * kGranule;
+    if (cursor_ == nullptr || rounded > static_cast<size_t>(limit_ - cursor_)) {
+      add_slab();
+    }
+
+    void* result = cursor_;
+    cursor_ += rounded;
+    return result;
+  }
+
+  void deallocate(void* ptr, size_t bytes, size_t alignment) noexcept {
+    if (bytes > kMaxClassBytes || alignment > kGranule) {
+      ::operator delete(ptr, std::align_val_t{alignment});
+      return;
+    }
+
+    FreeBlock*& head = free_lists_[class_of(bytes)];
+    head = ::new (ptr) FreeBlock{head};
+  }
+
+  size_t slab_count(Backing backing) const {
+    size_t count = 0;
+    for (const Slab& slab : slabs_) {
+      count += slab.backing == backing ? 1 : 0;
+    }
+    return count;
+  }
+
+  size_t bound_slab_count() const {
+    size_t count = 0;
+    for (const Slab& slab : slabs_) {
+      count += slab.bound ? 1 : 0;
+    }
+    return count;
+  }
+
+  const HugePageOptions& options() const { return options_; }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct Slab {
+    void* base;
+    Backing backing;
+    bool bound;
+  };
+
+  static constexpr int kMpolBind = 2;
+
+  HugePageOptions options_;
+  std::vector<Slab> slabs_;
+  std::array<FreeBlock*, kMaxClassBytes / kGranule> free_lists_{};
+  char* cursor_ = nullptr;
+  char* limit_ = nullptr;
+
+  static size_t class_of(size_t bytes) {
+    return bytes == 0 ? 0 : (bytes - 1) / kGranule;
+  }
+
+  static void* map(size_t bytes, int extra_flags) {
+    void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return addr == MAP_FAILED ? nullptr : addr;
+  }
+
+  // Over-maps by one slab and trims both ends so that the slab is 2 MiB
+  // aligned, which transparent huge pages need.
+  static void* map_aligned() {
+    char* raw = static_cast<char*>(map(2 * kSlabBytes, 0));
+    if (raw == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    uintptr_t addr = reinterpret_cast<uintptr_t>(raw);
+    char* base = reinterpret_cast<char*>((addr + kSlabBytes - 1) &
+                                         ~(kSlabBytes - 1));
+    if (base != raw) {
+      munmap(raw, base - raw);
+    }
+    munmap(base + kSlabBytes, raw + kSlabBytes - base);
+    return base;
+  }
+
+  // mbind has no glibc wrapper without libnuma, so it goes through syscall.
+  static bool bind_to_current_node(void* base) {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (getcpu(&cpu, &node) != 0 || node >= 64) {
+      return false;
+    }
+
+    unsigned long mask = 1UL << node;
+    return syscall(SYS_mbind, base, kSlabBytes, kMpolBind, &mask,
+                   sizeof(mask) * 8, 0) == 0;
+  }
+
+  // Makes room in slabs_ before mapping, so the push_back below cannot
+  // throw and leak the slab. Capacity grows geometrically to keep that
+  // amortized O(1).
+  void add_slab() {
+    if (slabs_.size() == slabs_.capacity()) {
+      slabs_.reserve(std::max<size_t>(2 * slabs_.size(), 8));
+    }
+
+    Slab slab{nullptr, Backing::Regular, false};
+    if (options_.huge_pages) {
+      slab.base = map(kSlabBytes, MAP_HUGETLB);
+      slab.backing = Backing::Hugetlb;
+    }
+    if (slab.base == nullptr) {
+      slab.base = map_aligned();
+      bool advised =
+          madvise(slab.base, kSlabBytes,
+                  options_.huge_pages ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) == 0;
+      slab.backing = options_.huge_pages && advised ? Backing::Transparent
+                                                    : Backing::Regular;
+    }
+
+    if (options_.bind_local_node) {
+      slab.bound = bind_to_current_node(slab.base);
+    }
+
+    slabs_.push_back(slab);
+    cursor_ = static_cast<char*>(slab.base);
+    limit_ = cursor_ + kSlabBytes;
+  }
+};
+
+// Allocator over a shared HugePageArena; rebound copies share the arena and
+// compare equal, so Lists using it can splice. The default constructor
+// creates a fresh arena with default options.
+template <typename T>
+class HugePageAllocator {
+ private:
+  std::shared_ptr<HugePageArena> arena_;
+
+  template <typename U>
+  friend class HugePageAllocator;
+
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  HugePageAllocator() : arena_(std::make_shared<HugePageArena>()) {}
+
+  explicit HugePageAllocator(HugePageOptions options)
+      : arena_(std::make_shared<HugePageArena>(options)) {}
+
+  explicit HugePageAllocator(std::shared_ptr<HugePageArena> arena)
+      : arena_(std::move(arena)) {}
+
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>& other)
+      : arena_(other.arena_) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) noexcept {
+    arena_->deallocate(ptr, n * sizeof(T), alignof(T));
+  }
+
+  HugePageArena& arena() const { return *arena_; }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+};
@@ -1,23 +1,183 @@
+#pragma once
+
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 class TruncatedNode {
  public:
   TruncatedNode* next;
   TruncatedNode* prev;
 
-  TruncatedNode() : next(this), prev(this) {}
+  constexpr TruncatedNode() : next(this), prev(this) {}
 
-  TruncatedNode(TruncatedNode* next, TruncatedNode* prev)
+  constexpr TruncatedNode(TruncatedNode* next, TruncatedNode* prev)
       : next(next), prev(prev) {}
 
-  TruncatedNode& operator=(const TruncatedNode& other) {
+  constexpr TruncatedNode& operator=(const TruncatedNode& other) {
     next = other.next;
     prev = other.prev;
     return *this;
   }
 
   ~TruncatedNode() = default;
+
+  // Pointer surgery on rings of TruncatedNodes. None of it depends on the
+  // element type, so the containers share these instead of each template
+  // instantiation carrying its own copy; only element construction and
+  // destruction stay in the templates. Outside constant evaluation every
+  // helper but join calls a single out-of-line copy below; join is two
+  // stores, less code than a call.
+
+  // Makes right the successor of left.
+  static constexpr void join(TruncatedNode* left, TruncatedNode* right) {
+    left->next = right;
+    right->prev = left;
+  }
+
+  static constexpr void link_before(TruncatedNode* pos, TruncatedNode* node) {
+    if (std::is_constant_evaluated()) {
+      link_before_impl(pos, node);
+    } else {
+      link_before_out_of_line(pos, node);
+    }
+  }
+
+  // Links the detached chain first .. last in front of pos.
+  static constexpr void link_range_before(TruncatedNode* pos,
+                                          TruncatedNode* first,
+                                          TruncatedNode* last) {
+    if (std::is_constant_evaluated()) {
+      link_range_before_impl(pos, first, last);
+    } else {
+      link_range_before_out_of_line(pos, first, last);
+    }
+  }
+
+  // The node keeps its stale links.
+  static constexpr void unlink(TruncatedNode* node) {
+    if (std::is_constant_evaluated()) {
+      unlink_impl(node);
+    } else {
+      unlink_out_of_line(node);
+    }
+  }
+
+  // Puts node where old was; old keeps its stale links.
+  static constexpr void replace(TruncatedNode* old, TruncatedNode* node) {
+    if (std::is_constant_evaluated()) {
+      replace_impl(old, node);
+    } else {
+      replace_out_of_line(old, node);
+    }
+  }
+
+  // Appends node to the detached chain first .. last, which is empty while
+  // first is null.
+  static constexpr void chain_push_back(TruncatedNode*& first,
+                                        TruncatedNode*& last,
+                                        TruncatedNode* node) {
+    if (std::is_constant_evaluated()) {
+      chain_push_back_impl(first, last, node);
+    } else {
+      chain_push_back_out_of_line(first, last, node);
+    }
+  }
+
+  constexpr void make_empty() {
+    next = this;
+    prev = this;
+  }
+
+  constexpr bool ring_empty() const { return next == this; }
+
+  // Moves the whole ring headed by the sentinel from into the sentinel to,
+  // whose own ring is dropped, and leaves from empty.
+  static constexpr void move_ring(TruncatedNode& from, TruncatedNode& to) {
+    if (std::is_constant_evaluated()) {
+      move_ring_impl(from, to);
+    } else {
+      move_ring_out_of_line(from, to);
+    }
+  }
+
+ private:
+  static constexpr void link_before_impl(TruncatedNode* pos,
+                                         TruncatedNode* node) {
+    join(pos->prev, node);
+    join(node, pos);
+  }
+
+  static constexpr void link_range_before_impl(TruncatedNode* pos,
+                                               TruncatedNode* first,
+                                               TruncatedNode* last) {
+    join(pos->prev, first);
+    join(last, pos);
+  }
+
+  static constexpr void unlink_impl(TruncatedNode* node) {
+    join(node->prev, node->next);
+  }
+
+  static constexpr void replace_impl(TruncatedNode* old, TruncatedNode* node) {
+    TruncatedNode* next = old->next;
+    join(old->prev, node);
+    join(node, next);
+  }
+
+  static constexpr void chain_push_back_impl(TruncatedNode*& first,
+                                             TruncatedNode*& last,
+                                             TruncatedNode* node) {
+    if (first == nullptr) {
+      first = node;
+    } else {
+      join(last, node);
+    }
+    last = node;
+  }
+
+  static constexpr void move_ring_impl(TruncatedNode& from,
+                                       TruncatedNode& to) {
+    to.make_empty();
+    if (!from.ring_empty()) {
+      link_range_before_impl(&to, from.next, from.prev);
+      from.make_empty();
+    }
+  }
+
+  [[gnu::noinline]] static void link_before_out_of_line(TruncatedNode* pos,
+                                                        TruncatedNode* node) {
+    link_before_impl(pos, node);
+  }
+
+  [[gnu::noinline]] static void link_range_before_out_of_line(
+      TruncatedNode* pos, TruncatedNode* first, TruncatedNode* last) {
+    link_range_before_impl(pos, first, last);
+  }
+
+  [[gnu::noinline]] static void unlink_out_of_line(TruncatedNode* node) {
+    unlink_impl(node);
+  }
+
+  [[gnu::noinline]] static void replace_out_of_line(TruncatedNode* old,
+                                                    TruncatedNode* node) {
+    replace_impl(old, node);
+  }
+
+  [[gnu::noinline]] static void chain_push_back_out_of_line(
+      TruncatedNode*& first, TruncatedNode*& last, TruncatedNode* node) {
+    chain_push_back_impl(first, last, node);
+  }
+
+  [[gnu::noinline]] static void move_ring_out_of_line(TruncatedNode& from,
+                                                      TruncatedNode& to) {
+    move_ring_impl(from, to);
+  }
 };
 
 template <typename T>
@@ -26,24 +186,31 @@ class Node : public TruncatedNode {
   T val_;
 
  public:
-  Node() {}
+  constexpr Node() : TruncatedNode(), val_() {}
+
+  constexpr Node(const T& val) : TruncatedNode(), val_(val) {}
+
+  constexpr Node(T&& val) : TruncatedNode(), val_(std::move(val)) {}
 
-  Node(const T& val) : val_(val), TruncatedNode() {}
+  template <typename... Args>
+  constexpr explicit Node(std::in_place_t, Args&&... args) noexcept(
+      std::is_nothrow_constructible_v<T, Args&&...>)
+      : TruncatedNode(), val_(std::forward<Args>(args)...) {}
 
-  Node(const T& val, TruncatedNode* next, TruncatedNode* prev)
-      : val_(val), TruncatedNode(next, prev) {}
+  constexpr Node(const T& val, TruncatedNode* next, TruncatedNode* prev)
+      : TruncatedNode(next, prev), val_(val) {}
 
-  Node(const Node& other)
-      : val_(other.val), TruncatedNode(other.next, other.prev) {}
+  constexpr Node(const Node& other)
+      : TruncatedNode(other.next, other.prev), val_(other.val_) {}
 
-  Node& operator=(const Node& other) {
+  constexpr Node& operator=(const Node& other) {
     val_ = other.val_;
     this->next = other.next;
     this->prev = other.prev;
     return *this;
   }
 
-  Node& operator=(const TruncatedNode& other) {
+  constexpr Node& operator=(const TruncatedNode& other) {
     this->next = other.next;
     this->prev = other.prev;
     return *this;
@@ -51,357 +218,692 @@ class Node : public TruncatedNode {
 
   ~Node() = default;
 
-  TruncatedNode* get_next() { return this->next; }
+  constexpr TruncatedNode* get_next() { return this->next; }
 
-  TruncatedNode* get_prev() { return this->prev; }
+  constexpr TruncatedNode* get_prev() { return this->prev; }
 
-  T& get_val() { return val_; }
+  constexpr T& get_val() { return val_; }
+};
+
+namespace Links {
+
+struct Double {};
+struct Single {};
+struct Xor {};
+
+}  // namespace Links
+
+namespace Size {
+
+struct Tracked {};
+struct Untracked {};
+
+}  // namespace Size
+
+template <typename SizePolicy>
+class SizeCounter;
+
+template <>
+class SizeCounter<Size::Tracked> {
+ private:
+  size_t size_ = 0;
+
+ public:
+  static constexpr bool kTracked = true;
+
+  constexpr void add(size_t n) { size_ += n; }
+
+  constexpr void sub(size_t n) { size_ -= n; }
+
+  constexpr void take(SizeCounter& other) {
+    size_ += other.size_;
+    other.size_ = 0;
+  }
+
+  constexpr void reset() { size_ = 0; }
+
+  constexpr size_t get() const { return size_; }
 };
 
-template <typename T, typename Alloc = std::allocator<T>>
+template <>
+class SizeCounter<Size::Untracked> {
+ public:
+  static constexpr bool kTracked = false;
+
+  constexpr void add(size_t) {}
+
+  constexpr void sub(size_t) {}
+
+  constexpr void take(SizeCounter&) {}
+
+  constexpr void reset() {}
+};
+
+template <typename T, typename Alloc = std::allocator<T>,
+          typename LinkPolicy = Links::Double,
+          typename SizePolicy = Size::Tracked>
 class List {
  private:
   TruncatedNode initial_node_;
-  size_t size_ = 0;
+  [[no_unique_address]] SizeCounter<SizePolicy> size_;
+  TruncatedNode cursors_;
+
+  static_assert(std::is_same_v<LinkPolicy, Links::Double>,
+                "unknown link policy");
 
   Alloc list_alloc_;
   using alloc_traits = std::allocator_traits<Alloc>;
-  typename alloc_traits::template rebind_alloc<Node<T>> node_alloc_;
+  using node_allocator_type =
+      typename alloc_traits::template rebind_alloc<Node<T>>;
+  node_allocator_type node_alloc_;
   using node_alloc_traits =
       typename alloc_traits::template rebind_traits<Node<T>>;
 
- public:
-  template <bool IsConst, bool IsReversed>
-  class Iterator;
-
-  using value_type = T;
-  using allocator_type = Alloc;
-  using iterator = Iterator<false, false>;
-  using const_iterator = Iterator<true, false>;
-  using reverse_iterator = Iterator<false, true>;
-  using const_reverse_iterator = Iterator<true, true>;
+  struct Chain {
+    TruncatedNode* first = nullptr;
+    TruncatedNode* last = nullptr;
+    size_t count = 0;
+  };
 
-  List() = default;
+  constexpr void destroy_node(TruncatedNode* node) {
+    node_alloc_traits::destroy(node_alloc_, static_cast<Node<T>*>(node));
+    node_alloc_traits::deallocate(node_alloc_, static_cast<Node<T>*>(node), 1);
+  }
 
-  void full_destroy(size_t upper_lim) {
-    auto cur = static_cast<Node<T>*>(initial_node_.next->next);
+  constexpr void destroy_chain(TruncatedNode* first, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      TruncatedNode* next = first->next;
+      destroy_node(first);
+      first = next;
+    }
+  }
 
-    for (size_t i = 0; i < upper_lim; i++) {
-      node_alloc_traits::destroy(node_alloc_, static_cast<Node<T>*>(cur->prev));
-      node_alloc_traits::deallocate(node_alloc_,
-                                    static_cast<Node<T>*>(cur->prev), 1);
-      cur = static_cast<Node<T>*>(cur->next);
+  constexpr void destroy_range(TruncatedNode* first, TruncatedNode* last) {
+    while (first != last) {
+      TruncatedNode* next = first->next;
+      destroy_node(first);
+      first = next;
     }
   }
 
-  List(size_t count, const T& value, const Alloc& alloc = Alloc())
-      : list_alloc_(alloc) {
-    Node<T>* cur = node_alloc_traits::allocate(node_alloc_, 1);
+  // Owns a freshly allocated, not yet constructed node and gives the memory
+  // back unless the node is released.
+  class NodeGuard {
+   private:
+    List* list_;
+    Node<T>* node_;
 
-    try {
-      node_alloc_traits::construct(node_alloc_, cur, value);
-      size_++;
-
-      initial_node_.next = cur;
-      cur->prev = static_cast<Node<T>*>(&initial_node_);
-
-      for (size_t i = 0; i < count - 1; i++, size_++) {
-        cur->next = node_alloc_traits::allocate(node_alloc_, 1);
-        node_alloc_traits::construct(node_alloc_,
-                                     static_cast<Node<T>*>(cur->next), value);
-        cur->next->prev = cur;
-        cur = static_cast<Node<T>*>(cur->next);
+   public:
+    constexpr explicit NodeGuard(List* list)
+        : list_(list),
+          node_(node_alloc_traits::allocate(list->node_alloc_, 1)) {}
+
+    NodeGuard(const NodeGuard&) = delete;
+    NodeGuard& operator=(const NodeGuard&) = delete;
+
+    constexpr ~NodeGuard() {
+      if (node_ != nullptr) {
+        node_alloc_traits::deallocate(list_->node_alloc_, node_, 1);
       }
-    } catch (...) {
-      full_destroy(size_ - 1);
-      node_alloc_traits::deallocate(node_alloc_,
-                                    static_cast<Node<T>*>(cur->next), 1);
-      node_alloc_traits::destroy(node_alloc_, cur);
-      node_alloc_traits::deallocate(node_alloc_, cur, 1);
-      throw 1;
     }
 
-    cur->next = static_cast<Node<T>*>(&initial_node_);
-    initial_node_.prev = cur;
-  }
+    constexpr Node<T>* get() const { return node_; }
+
+    constexpr Node<T>* release() {
+      Node<T>* node = node_;
+      node_ = nullptr;
+      return node;
+    }
+  };
 
-  explicit List(size_t count, const Alloc& alloc = Alloc())
-      : list_alloc_(alloc) {
-    Node<T>* cur = node_alloc_traits::allocate(node_alloc_, 1);
+  // Owns a detached chain under construction and destroys it unless the
+  // chain is released, e.g. into a list.
+  class ChainGuard {
+   private:
+    List* list_;
+    Chain chain_;
 
-    try {
-      node_alloc_traits::construct(node_alloc_, cur);
-      size_++;
-
-      initial_node_.next = cur;
-      cur->prev = static_cast<Node<T>*>(&initial_node_);
-
-      for (size_t i = 0; i < count - 1; i++, size_++) {
-        cur->next = node_alloc_traits::allocate(node_alloc_, 1);
-        node_alloc_traits::construct(node_alloc_,
-                                     static_cast<Node<T>*>(cur->next));
-        cur->next->prev = cur;
-        cur = static_cast<Node<T>*>(cur->next);
+   public:
+    constexpr explicit ChainGuard(List* list) : list_(list) {}
+
+    constexpr ChainGuard(List* list, const Chain& chain)
+        : list_(list), chain_(chain) {}
+
+    ChainGuard(const ChainGuard&) = delete;
+    ChainGuard& operator=(const ChainGuard&) = delete;
+
+    constexpr ~ChainGuard() {
+      if (list_ != nullptr) {
+        list_->destroy_chain(chain_.first, chain_.count);
       }
-    } catch (...) {
-      full_destroy(size_ - 1);
-      node_alloc_traits::deallocate(node_alloc_,
-                                    static_cast<Node<T>*>(cur->next), 1);
-      node_alloc_traits::destroy(node_alloc_, cur);
-      node_alloc_traits::deallocate(node_alloc_, cur, 1);
+    }
 
-      throw 1;
+    constexpr void push_back(TruncatedNode* node) {
+      TruncatedNode::chain_push_back(chain_.first, chain_.last, node);
+      chain_.count++;
     }
 
-    cur->next = static_cast<Node<T>*>(&initial_node_);
-    initial_node_.prev = cur;
+    constexpr Chain release() {
+      list_ = nullptr;
+      return chain_;
+    }
+  };
+
+  template <typename... Args>
+  static constexpr bool kNothrowCreate =
+      noexcept(std::declval<node_allocator_type&>().allocate(1)) &&
+      noexcept(node_alloc_traits::construct(
+          std::declval<node_allocator_type&>(), std::declval<Node<T>*>(),
+          std::in_place, std::declval<Args>()...));
+
+  template <typename... Args>
+  constexpr Node<T>* create_node(Args&&... args) noexcept(
+      kNothrowCreate<Args...>) {
+    NodeGuard guard(this);
+    node_alloc_traits::construct(node_alloc_, guard.get(), std::in_place,
+                                 std::forward<Args>(args)...);
+    return guard.release();
   }
 
-  List(const List<T, Alloc>& other) {
-    auto beg = other.begin();
-    auto end = other.end();
-
-    Node<T>* cur = node_alloc_traits::allocate(node_alloc_, 1);
+  // Builds a detached chain of nodes. If anything throws, the nodes built so
+  // far are released and the original exception is passed on.
+  template <typename InputIt>
+  constexpr Chain build_chain(InputIt first, InputIt last) {
+    ChainGuard guard(this);
+    for (; first != last; ++first) {
+      guard.push_back(create_node(*first));
+    }
+    return guard.release();
+  }
 
-    try {
-      node_alloc_traits::construct(node_alloc_, cur, *beg);
-      size_++;
+  template <typename... Args>
+  constexpr Chain build_chain_n(size_t count, const Args&... args) {
+    ChainGuard guard(this);
+    for (size_t i = 0; i < count; i++) {
+      guard.push_back(create_node(args...));
+    }
+    return guard.release();
+  }
 
-      initial_node_.next = cur;
-      cur->prev = static_cast<Node<T>*>(&initial_node_);
+  constexpr void link_chain(TruncatedNode* pos, const Chain& chain) {
+    if (chain.first == nullptr) {
+      return;
+    }
 
-      ++beg;
-      for (; beg != end; ++beg, size_++) {
-        cur->next = node_alloc_traits::allocate(node_alloc_, 1);
-        node_alloc_traits::construct(node_alloc_,
-                                     static_cast<Node<T>*>(cur->next), *beg);
-        cur->next->prev = cur;
+    TruncatedNode::link_range_before(pos, chain.first, chain.last);
 
-        cur = static_cast<Node<T>*>(cur->next);
-      }
+    size_.add(chain.count);
+  }
 
-      cur->next = static_cast<Node<T>*>(&initial_node_);
-      initial_node_.prev = cur;
-    } catch (...) {
-      full_destroy(size_ - 1);
-      node_alloc_traits::deallocate(node_alloc_,
-                                    static_cast<Node<T>*>(cur->next), 1);
-      node_alloc_traits::destroy(node_alloc_, cur);
-      node_alloc_traits::deallocate(node_alloc_, cur, 1);
-      throw 1;
+  constexpr void fix_sentinel(bool was_empty) {
+    if (was_empty) {
+      initial_node_.make_empty();
+    } else {
+      TruncatedNode::join(&initial_node_, initial_node_.next);
+      TruncatedNode::join(initial_node_.prev, &initial_node_);
     }
-
-    list_alloc_ =
-        alloc_traits::select_on_container_copy_construction(other.list_alloc_);
-    node_alloc_ =
-        alloc_traits::select_on_container_copy_construction(other.node_alloc_);
   }
 
-  List(std::initializer_list<T> init, const Alloc& alloc = Alloc())
-      : list_alloc_(alloc) {
-    auto iter = init.begin();
-    auto init_end = init.end();
+  constexpr bool has_cursors() const { return cursors_.next != &cursors_; }
 
-    Node<T>* cur = node_alloc_traits::allocate(node_alloc_, 1);
+  // Cursors standing on node move on to its successor.
+  constexpr void skip_cursors(TruncatedNode* node);
 
-    try {
-      node_alloc_traits::construct(node_alloc_, cur, *iter);
-      size_++;
+  // Cursors standing on from now stand on to.
+  constexpr void move_cursors(TruncatedNode* from, TruncatedNode* to);
+
+  // Used when the whole chain is dropped or handed to another list.
+  constexpr void reset_cursors();
 
-      initial_node_.next = cur;
-      cur->prev = static_cast<Node<T>*>(&initial_node_);
+  constexpr void detach_cursors();
+
+  constexpr void erase_node(TruncatedNode* node) {
+    if (has_cursors()) {
+      skip_cursors(node);
+    }
 
-      iter++;
-      for (; iter < init_end; iter++, size_++) {
-        cur->next = node_alloc_traits::allocate(node_alloc_, 1);
-        node_alloc_traits::construct(node_alloc_,
-                                     static_cast<Node<T>*>(cur->next), *iter);
-        cur->next->prev = cur;
+    TruncatedNode::unlink(node);
+    destroy_node(node);
+    size_.sub(1);
+  }
 
-        cur = static_cast<Node<T>*>(cur->next);
+  // Moves up to budget elements starting at cur into fresh nodes, which
+  // take the place of the old ones, and leaves cur after the last of them.
+  // The old nodes go to retired instead of back to the allocator, so an
+  // allocator handing out consecutive addresses (malloc's top chunk, a bump
+  // arena) does not recycle them for the fresh ones. Elements are moved with
+  // move_if_noexcept: if building a node throws, that element is untouched
+  // and the ones relocated before it stay relocated.
+  constexpr size_t relocate(TruncatedNode*& cur, size_t budget,
+                            ChainGuard& retired) {
+    size_t moved = 0;
+
+    for (; moved < budget && cur != &initial_node_; moved++) {
+      TruncatedNode* fresh = create_node(
+          std::move_if_noexcept(static_cast<Node<T>*>(cur)->get_val()));
+      TruncatedNode* next = cur->next;
+
+      TruncatedNode::replace(cur, fresh);
+
+      if (has_cursors()) {
+        move_cursors(cur, fresh);
       }
 
-      cur->next = static_cast<Node<T>*>(&initial_node_);
-      initial_node_.prev = cur;
-    } catch (...) {
-      full_destroy(size_ - 1);
-      node_alloc_traits::deallocate(node_alloc_,
-                                    static_cast<Node<T>*>(cur->next), 1);
-      node_alloc_traits::destroy(node_alloc_, cur);
-      node_alloc_traits::deallocate(node_alloc_, cur, 1);
-      throw 1;
+      retired.push_back(cur);
+      cur = next;
     }
+
+    return moved;
   }
 
-  List& operator=(const List<T, Alloc>& other) {
-    List<T, Alloc> temp(other);
+  // Exchanges the node chains (and sizes) of two lists, allocators stay put.
+  constexpr void swap_links(List& other) {
+    reset_cursors();
+    other.reset_cursors();
 
-    std::swap(size_, temp.size_);
-    std::swap(initial_node_, temp.initial_node_);
+    bool this_empty = empty();
+    bool other_empty = other.empty();
 
-    initial_node_.next->prev = &initial_node_;
-    initial_node_.prev->next = &initial_node_;
+    std::swap(initial_node_, other.initial_node_);
+    std::swap(size_, other.size_);
 
-    if (temp.size_ == 0) {
-      temp.initial_node_.next = &temp.initial_node_;
-      temp.initial_node_.prev = &temp.initial_node_;
+    fix_sentinel(other_empty);
+    other.fix_sentinel(this_empty);
+  }
+
+  constexpr bool node_alloc_equals(const List& other) const {
+    if constexpr (node_alloc_traits::is_always_equal::value) {
+      return true;
     } else {
-      temp.initial_node_.next->prev = &temp.initial_node_;
-      temp.initial_node_.prev->next = &temp.initial_node_;
+      return node_alloc_ == other.node_alloc_;
     }
+  }
+
+ public:
+  template <bool IsConst, bool IsReversed>
+  class Iterator;
+
+  class Cursor;
+
+  using value_type = T;
+  using allocator_type = Alloc;
+  using iterator = Iterator<false, false>;
+  using const_iterator = Iterator<true, false>;
+  using reverse_iterator = Iterator<false, true>;
+  using const_reverse_iterator = Iterator<true, true>;
+
+  List() = default;
+
+  explicit constexpr List(const Alloc& alloc)
+      : list_alloc_(alloc), node_alloc_(alloc) {}
+
+  constexpr List(size_t count, const T& value, const Alloc& alloc = Alloc())
+      : List(alloc) {
+    link_chain(&initial_node_, build_chain_n(count, value));
+  }
 
-    if (node_alloc_traits::propagate_on_container_copy_assignment::value &&
-        list_alloc_ != other.list_alloc_) {
-      list_alloc_ = other.list_alloc_;
+  explicit constexpr List(size_t count, const Alloc& alloc = Alloc())
+      : List(alloc) {
+    link_chain(&initial_node_, build_chain_n(count));
+  }
+
+  constexpr List(const List& other)
+      : List(other, alloc_traits::select_on_container_copy_construction(
+                        other.list_alloc_)) {}
+
+  constexpr List(const List& other, const Alloc& alloc) : List(alloc) {
+    link_chain(&initial_node_, build_chain(other.begin(), other.end()));
+  }
+
+  constexpr List(std::initializer_list<T> init, const Alloc& alloc = Alloc())
+      : List(alloc) {
+    link_chain(&initial_node_, build_chain(init.begin(), init.end()));
+  }
+
+  constexpr List(List&& other) noexcept
+      : list_alloc_(other.list_alloc_), node_alloc_(other.node_alloc_) {
+    swap_links(other);
+  }
+
+  // The copy is built with the allocator this list ends up with, so nodes
+  // are always released through the allocator that produced them.
+  constexpr List& operator=(const List& other) {
+    constexpr bool kPropagate =
+        node_alloc_traits::propagate_on_container_copy_assignment::value;
+
+    List temp(other, kPropagate ? other.list_alloc_ : list_alloc_);
+    swap_links(temp);
+
+    if constexpr (kPropagate) {
+      std::swap(list_alloc_, temp.list_alloc_);
+      std::swap(node_alloc_, temp.node_alloc_);
     }
 
     return *this;
   }
 
-  size_t size() const { return size_; }
+  // Nodes can only change hands when the allocators allow it, otherwise the
+  // elements are moved into nodes of this list's allocator.
+  constexpr List& operator=(List&& other) {
+    if (this == &other) {
+      return *this;
+    }
 
-  bool empty() const { return size_ == 0; }
+    constexpr bool kPropagate =
+        node_alloc_traits::propagate_on_container_move_assignment::value;
 
-  ~List() { full_destroy(size_); }
+    if (kPropagate || node_alloc_equals(other)) {
+      clear();
+      swap_links(other);
 
-  Alloc get_allocator() const { return list_alloc_; }
+      if constexpr (kPropagate) {
+        list_alloc_ = other.list_alloc_;
+        node_alloc_ = other.node_alloc_;
+      }
+    } else {
+      List temp(list_alloc_);
+      temp.push_back_n(std::make_move_iterator(other.begin()),
+                       std::make_move_iterator(other.end()));
+      other.clear();
+      clear();
+      swap_links(temp);
+    }
 
-  T& front() { return static_cast<Node<T>>(initial_node_.next).get_val(); }
+    return *this;
+  }
 
-  const T& front() const {
-    return static_cast<Node<T>>(initial_node_.next).get_val();
+  constexpr size_t size() const
+    requires SizeCounter<SizePolicy>::kTracked
+  {
+    return size_.get();
   }
 
-  T& back() { return static_cast<Node<T>>(initial_node_.prev).get_val(); }
+  constexpr bool empty() const { return initial_node_.next == &initial_node_; }
 
-  const T& back() const {
-    return static_cast<Node<T>>(initial_node_.prev).get_val();
+  constexpr ~List() {
+    detach_cursors();
+    destroy_range(initial_node_.next, &initial_node_);
   }
 
-  void push_back(const T& val) {
-    try {
-      push_back(std::move(val));
-    } catch (int) {
-      throw 1;
-    }
+  constexpr Alloc get_allocator() const { return list_alloc_; }
+
+  constexpr void clear() {
+    reset_cursors();
+    destroy_range(initial_node_.next, &initial_node_);
+
+    initial_node_.make_empty();
+    size_.reset();
   }
 
-  void push_front(const T& val) {
-    try {
-      push_front(std::move(val));
-    } catch (int) {
-      throw 1;
-    }
+  constexpr T& front() {
+    return static_cast<Node<T>*>(initial_node_.next)->get_val();
   }
 
-  void push_back(T&& val) {
-    Node<T>* node_to_push = node_alloc_traits::allocate(node_alloc_, 1);
+  constexpr const T& front() const {
+    return static_cast<Node<T>*>(initial_node_.next)->get_val();
+  }
 
-    try {
-      node_alloc_traits::construct(node_alloc_, node_to_push, val);
-    } catch (...) {
-      node_alloc_traits::deallocate(node_alloc_, node_to_push, 1);
+  constexpr T& back() {
+    return static_cast<Node<T>*>(initial_node_.prev)->get_val();
+  }
+
+  constexpr const T& back() const {
+    return static_cast<Node<T>*>(initial_node_.prev)->get_val();
+  }
+
+  // Strong guarantee: if the node cannot be built the list is unchanged.
+  // Never throws when neither the allocation nor the element constructor can.
+  template <typename... Args>
+  constexpr T& emplace_back(Args&&... args) noexcept(kNothrowCreate<Args...>) {
+    Node<T>* node = create_node(std::forward<Args>(args)...);
+    link_chain(&initial_node_, {node, node, 1});
+    return node->get_val();
+  }
+
+  template <typename... Args>
+  constexpr T& emplace_front(Args&&... args) noexcept(
+      kNothrowCreate<Args...>) {
+    Node<T>* node = create_node(std::forward<Args>(args)...);
+    link_chain(initial_node_.next, {node, node, 1});
+    return node->get_val();
+  }
+
+  constexpr void push_back(const T& val) noexcept(kNothrowCreate<const T&>) {
+    emplace_back(val);
+  }
+
+  constexpr void push_front(const T& val) noexcept(kNothrowCreate<const T&>) {
+    emplace_front(val);
+  }
+
+  constexpr void push_back(T&& val) noexcept(kNothrowCreate<T&&>) {
+    emplace_back(std::move(val));
+  }
+
+  constexpr void push_front(T&& val) noexcept(kNothrowCreate<T&&>) {
+    emplace_front(std::move(val));
+  }
+
+  template <typename... Args>
+  constexpr iterator emplace(const_iterator pos, Args&&... args) {
+    Node<T>* node = create_node(std::forward<Args>(args)...);
+    link_chain(pos.cur_node_, {node, node, 1});
+    return iterator(node);
+  }
+
+  constexpr iterator insert(const_iterator pos, const T& val) {
+    return emplace(pos, val);
+  }
+
+  constexpr iterator insert(const_iterator pos, T&& val) {
+    return emplace(pos, std::move(val));
+  }
+
+  constexpr iterator erase(const_iterator pos) noexcept {
+    TruncatedNode* next = pos.cur_node_->next;
+    erase_node(pos.cur_node_);
+    return iterator(next);
+  }
+
+  // Appends [first, last) with a single relink and size update. Either every
+  // element is appended or the list is left untouched.
+  template <typename InputIt>
+  constexpr void push_back_n(InputIt first, InputIt last) {
+    link_chain(&initial_node_, build_chain(first, last));
+  }
+
+  // Steals the nodes of other when the allocators allow it, otherwise moves
+  // the elements over. other is left empty either way.
+  constexpr void append(List&& other) {
+    if (other.empty()) {
+      return;
     }
 
-    node_to_push->prev = static_cast<Node<T>*>(initial_node_.prev);
-    initial_node_.prev->next = node_to_push;
+    if (!node_alloc_equals(other)) {
+      push_back_n(std::make_move_iterator(other.begin()),
+                  std::make_move_iterator(other.end()));
+      other.clear();
+      return;
+    }
 
-    node_to_push->next = static_cast<Node<T>*>(&initial_node_);
-    initial_node_.prev = node_to_push;
+    other.reset_cursors();
+    Chain chain{other.initial_node_.next, other.initial_node_.prev, 0};
+    other.initial_node_.make_empty();
 
-    size_++;
+    link_chain(&initial_node_, chain);
+    size_.take(other.size_);
   }
 
-  void push_front(T&& val) {
-    Node<T>* node_to_push = node_alloc_traits::allocate(node_alloc_, 1);
+  // Copies other split into up to executor.concurrency() contiguous pieces.
+  // Each piece is built into its own List, with its own copy of the
+  // allocator, by one task; the pieces are then spliced together in order.
+  // Executor provides concurrency() and bulk(n, f), which runs f(0) ..
+  // f(n - 1), returns once all are done and rethrows the first exception.
+  // Copies of the allocator have to be usable from several threads at once.
+  // If a task throws, every piece is destroyed and the exception passed on.
+  template <typename Executor>
+  static List parallel_copy(const List& other, Executor& executor) {
+    constexpr size_t kMinPiece = 4096;
+
+    Alloc alloc =
+        alloc_traits::select_on_container_copy_construction(other.list_alloc_);
 
-    try {
-      node_alloc_traits::construct(node_alloc_, node_to_push, val);
-    } catch (...) {
-      node_alloc_traits::deallocate(node_alloc_, node_to_push, 1);
+    size_t count = 0;
+    if constexpr (SizeCounter<SizePolicy>::kTracked) {
+      count = other.size();
+    } else {
+      count = static_cast<size_t>(std::distance(other.begin(), other.end()));
+    }
+
+    size_t pieces = std::min(executor.concurrency(), count / kMinPiece);
+    if (pieces <= 1) {
+      return List(other, alloc);
     }
 
-    node_to_push->next = static_cast<Node<T>*>(initial_node_.next);
-    initial_node_.next->prev = node_to_push;
+    size_t piece_size = (count + pieces - 1) / pieces;
+    std::vector<const_iterator> bounds;
+    bounds.reserve(pieces + 1);
+    size_t index = 0;
+    for (auto it = other.begin(); it != other.end(); ++it, ++index) {
+      if (index % piece_size == 0) {
+        bounds.push_back(it);
+      }
+    }
+    bounds.push_back(other.end());
+    pieces = bounds.size() - 1;
+
+    std::vector<List> parts;
+    parts.reserve(pieces);
+    for (size_t i = 0; i < pieces; i++) {
+      parts.emplace_back(alloc);
+    }
 
-    node_to_push->prev = static_cast<Node<T>*>(&initial_node_);
-    initial_node_.next = node_to_push;
+    executor.bulk(pieces, [&parts, &bounds](size_t i) {
+      parts[i].push_back_n(bounds[i], bounds[i + 1]);
+    });
 
-    size_++;
+    List result(alloc);
+    for (List& part : parts) {
+      result.append(std::move(part));
+    }
+    return result;
   }
 
-  void pop_back() noexcept {
-    initial_node_.prev = initial_node_.prev->prev;
+  // Moves up to n front elements into out, then unlinks them all at once.
+  template <typename OutputIt>
+  constexpr OutputIt pop_front_n(size_t n, OutputIt out) {
+    TruncatedNode* first = initial_node_.next;
+    TruncatedNode* cur = first;
+    size_t popped = 0;
+
+    for (; popped < n && cur != &initial_node_; popped++, cur = cur->next) {
+      *out = std::move(static_cast<Node<T>*>(cur)->get_val());
+      ++out;
 
-    node_alloc_traits::destroy(node_alloc_,
-                               static_cast<Node<T>*>(initial_node_.prev->next));
-    node_alloc_traits::deallocate(
-        node_alloc_, static_cast<Node<T>*>(initial_node_.prev->next), 1);
+      if (has_cursors()) {
+        skip_cursors(cur);
+      }
+    }
 
-    initial_node_.prev->next = &initial_node_;
+    TruncatedNode::join(&initial_node_, cur);
+    size_.sub(popped);
 
-    size_--;
+    destroy_chain(first, popped);
+    return out;
   }
 
-  void pop_front() noexcept {
-    initial_node_.next = initial_node_.next->next;
+  constexpr void pop_back() noexcept { erase_node(initial_node_.prev); }
 
-    node_alloc_traits::destroy(node_alloc_,
-                               static_cast<Node<T>*>(initial_node_.next->prev));
-    node_alloc_traits::deallocate(
-        node_alloc_, static_cast<Node<T>*>(initial_node_.next->prev), 1);
+  constexpr void pop_front() noexcept { erase_node(initial_node_.next); }
 
-    initial_node_.next->prev = &initial_node_;
+  // Reallocates every node in traversal order so that a list fragmented by
+  // long churn is walked front to back through (mostly) ascending
+  // addresses again. Iterators, pointers and references to elements are
+  // invalidated; cursors stay on their elements.
+  constexpr void compact() {
+    ChainGuard retired(this);
+    TruncatedNode* cur = initial_node_.next;
+    relocate(cur, static_cast<size_t>(-1), retired);
+  }
 
-    size_--;
+  // Incremental compact: relocates at most budget elements starting at the
+  // cursor, which must belong to this list, and leaves the cursor after
+  // them. Fewer than budget relocated elements means the end was reached.
+  // The cursor keeps the old nodes of its pass until the pass reaches the
+  // end or the cursor is reset or destroyed, so a full pass peaks at twice
+  // the list's node memory.
+  size_t compact(Cursor& cursor, size_t budget) {
+    ChainGuard retired(this, cursor.retired_);
+    cursor.retired_ = Chain{};
+
+    // relocate retargets cursor along with the others, so it works on a copy.
+    TruncatedNode* cur = cursor.node_;
+    size_t moved = relocate(cur, budget, retired);
+    cursor.node_ = cur;
+
+    if (cur != &initial_node_) {
+      cursor.retired_ = retired.release();
+    }
+    return moved;
   }
 
-  iterator begin() { return iterator(initial_node_.next); }
+  constexpr iterator begin() { return iterator(initial_node_.next); }
 
-  iterator end() {
+  constexpr iterator end() {
     return iterator(const_cast<TruncatedNode*>(&initial_node_));
   }
 
-  const_iterator begin() const { return const_iterator(initial_node_.next); }
+  constexpr const_iterator begin() const {
+    return const_iterator(initial_node_.next);
+  }
 
-  const_iterator end() const {
+  constexpr const_iterator end() const {
     return const_iterator(const_cast<TruncatedNode*>(&initial_node_));
   }
 
-  const_iterator cbegin() const { return const_iterator(initial_node_.next); }
+  constexpr const_iterator cbegin() const {
+    return const_iterator(initial_node_.next);
+  }
 
-  const_iterator cend() const {
+  constexpr const_iterator cend() const {
     return const_iterator(const_cast<TruncatedNode*>(&initial_node_));
   }
 
-  reverse_iterator rbegin() { return reverse_iterator(initial_node_.prev); }
+  constexpr reverse_iterator rbegin() {
+    return reverse_iterator(initial_node_.prev);
+  }
 
-  reverse_iterator rend() {
+  constexpr reverse_iterator rend() {
     return reverse_iterator(const_cast<TruncatedNode*>(&initial_node_));
   }
 
-  const_reverse_iterator rbegin() const {
+  constexpr const_reverse_iterator rbegin() const {
     return const_reverse_iterator(initial_node_.prev);
   }
 
-  const_reverse_iterator rend() const {
+  constexpr const_reverse_iterator rend() const {
     return const_reverse_iterator(const_cast<TruncatedNode*>(&initial_node_));
   }
 
-  const_reverse_iterator crbegin() const {
+  constexpr const_reverse_iterator crbegin() const {
     return const_reverse_iterator(initial_node_.prev);
   }
 
-  const_reverse_iterator crend() const {
+  constexpr const_reverse_iterator crend() const {
     return const_reverse_iterator(const_cast<TruncatedNode*>(&initial_node_));
   }
 };
 
-template <typename T, typename Alloc>
+template <typename T, typename Alloc, typename LinkPolicy, typename SizePolicy>
 template <bool IsConst, bool IsReversed>
-class List<T, Alloc>::Iterator {
+class List<T, Alloc, LinkPolicy, SizePolicy>::Iterator {
  private:
-  Node<T>* cur_node_;
+  TruncatedNode* cur_node_ = nullptr;
+
+  template <bool, bool>
+  friend class Iterator;
+
+  friend List<T, Alloc, LinkPolicy, SizePolicy>;
 
  public:
   using is_const = std::conditional_t<IsConst, const T, T>;
@@ -413,49 +915,1028 @@ class List<T, Alloc>::Iterator {
 
   Iterator() = default;
 
-  Iterator(TruncatedNode* node) : cur_node_(static_cast<Node<T>*>(node)) {}
+  constexpr Iterator(TruncatedNode* node) : cur_node_(node) {}
+
+  template <bool OtherConst>
+    requires(IsConst && !OtherConst)
+  constexpr Iterator(const Iterator<OtherConst, IsReversed>& other)
+      : cur_node_(other.cur_node_) {}
 
   ~Iterator() = default;
 
-  Iterator& operator++() {
+  constexpr Iterator& operator++() {
     if (IsReversed) {
-      cur_node_ = static_cast<Node<T>*>(cur_node_->prev);
+      cur_node_ = cur_node_->prev;
     } else {
-      cur_node_ = static_cast<Node<T>*>(cur_node_->next);
+      cur_node_ = cur_node_->next;
     }
     return *this;
   }
 
-  Iterator operator++(int) {
+  constexpr Iterator operator++(int) {
     auto temp(*this);
     ++*this;
     return temp;
   }
 
-  Iterator& operator--() {
+  constexpr Iterator& operator--() {
     if (IsReversed) {
-      cur_node_ = static_cast<Node<T>*>(cur_node_->next);
+      cur_node_ = cur_node_->next;
     } else {
-      cur_node_ = static_cast<Node<T>*>(cur_node_->prev);
+      cur_node_ = cur_node_->prev;
     }
     return *this;
   }
 
-  Iterator operator--(int) {
+  constexpr Iterator operator--(int) {
     auto temp(*this);
     --*this;
     return temp;
   }
 
-  reference operator*() const { return cur_node_->get_val(); }
+  constexpr reference operator*() const {
+    return static_cast<Node<T>*>(cur_node_)->get_val();
+  }
 
-  pointer operator->() const { return &(cur_node_->get_val()); }
+  constexpr pointer operator->() const {
+    return &(static_cast<Node<T>*>(cur_node_)->get_val());
+  }
 
-  bool operator==(const Iterator<IsConst, IsReversed>& other) const {
+  constexpr bool operator==(
+      const Iterator<IsConst, IsReversed>& other) const {
     return cur_node_ == other.cur_node_;
   }
 
-  bool operator!=(const Iterator<IsConst, IsReversed>& other) const {
+  constexpr bool operator!=(
+      const Iterator<IsConst, IsReversed>& other) const {
     return cur_node_ != other.cur_node_;
   }
-};
\ No newline at end of file
+};
+
+// Position in a List that stays valid across insertions and erasures
+// anywhere in the list, including of the element it stands on: the cursor
+// then moves on to the next element. Cursors are TruncatedNodes linked into
+// a ring hanging off the list's cursors_ sentinel, which the erasing
+// operations consult. Dropping the whole chain (clear, assignment, append
+// into another list) sends cursors to end(); destroying the list detaches
+// them. Meant for spreading a traversal over many event loop ticks.
+template <typename T, typename Alloc, typename LinkPolicy, typename SizePolicy>
+class List<T, Alloc, LinkPolicy, SizePolicy>::Cursor : private TruncatedNode {
+ private:
+  List* list_ = nullptr;
+  TruncatedNode* node_ = nullptr;
+
+  // Old nodes of an incremental compact pass, see List::compact.
+  Chain retired_;
+
+  friend List<T, Alloc, LinkPolicy, SizePolicy>;
+
+  void release_retired() {
+    list_->destroy_chain(retired_.first, retired_.count);
+    retired_ = Chain{};
+  }
+
+  void attach(List* list, TruncatedNode* node) {
+    list_ = list;
+    node_ = node;
+    if (list_ == nullptr) {
+      return;
+    }
+
+    TruncatedNode::link_before(list_->cursors_.next, this);
+  }
+
+  void detach() {
+    if (list_ != nullptr) {
+      release_retired();
+      TruncatedNode::unlink(this);
+    }
+    list_ = nullptr;
+    node_ = nullptr;
+  }
+
+ public:
+  Cursor() = default;
+
+  explicit Cursor(List& list) { attach(&list, list.initial_node_.next); }
+
+  Cursor(List& list, const_iterator pos) { attach(&list, pos.cur_node_); }
+
+  Cursor(const Cursor& other) { attach(other.list_, other.node_); }
+
+  Cursor& operator=(const Cursor& other) {
+    if (this != &other) {
+      detach();
+      attach(other.list_, other.node_);
+    }
+    return *this;
+  }
+
+  ~Cursor() { detach(); }
+
+  bool attached() const { return list_ != nullptr; }
+
+  bool at_end() const {
+    return list_ == nullptr || node_ == &list_->initial_node_;
+  }
+
+  T& operator*() const { return static_cast<Node<T>*>(node_)->get_val(); }
+
+  T* operator->() const { return &static_cast<Node<T>*>(node_)->get_val(); }
+
+  iterator position() const { return iterator(node_); }
+
+  void reset() {
+    if (list_ != nullptr) {
+      release_retired();
+      node_ = list_->initial_node_.next;
+    }
+  }
+
+  // Moves up to n elements forward, returns how many steps were taken.
+  size_t advance(size_t n) {
+    size_t steps = 0;
+    for (; steps < n && !at_end(); steps++) {
+      node_ = node_->next;
+    }
+    return steps;
+  }
+
+  // Visits at most budget elements starting at the cursor and leaves the
+  // cursor after the last visited one. The cursor is moved before func runs,
+  // so func may insert or erase elements, the visited one included.
+  // Returns the number of visited elements; fewer than budget means the
+  // traversal reached the end.
+  template <typename F>
+  size_t for_each_chunk(size_t budget, F func) {
+    size_t visited = 0;
+    for (; visited < budget && !at_end(); visited++) {
+      TruncatedNode* node = node_;
+      node_ = node_->next;
+      func(static_cast<Node<T>*>(node)->get_val());
+    }
+    return visited;
+  }
+};
+
+template <typename T, typename Alloc, typename LinkPolicy, typename SizePolicy>
+constexpr void List<T, Alloc, LinkPolicy, SizePolicy>::skip_cursors(
+    TruncatedNode* node) {
+  for (TruncatedNode* cur = cursors_.next; cur != &cursors_; cur = cur->next) {
+    auto cursor = static_cast<Cursor*>(cur);
+    if (cursor->node_ == node) {
+      cursor->node_ = node->next;
+    }
+  }
+}
+
+template <typename T, typename Alloc, typename LinkPolicy, typename SizePolicy>
+constexpr void List<T, Alloc, LinkPolicy, SizePolicy>::move_cursors(
+    TruncatedNode* from, TruncatedNode* to) {
+  for (TruncatedNode* cur = cursors_.next; cur != &cursors_; cur = cur->next) {
+    auto cursor = static_cast<Cursor*>(cur);
+    if (cursor->node_ == from) {
+      cursor->node_ = to;
+    }
+  }
+}
+
+template <typename T, typename Alloc, typename LinkPolicy, typename SizePolicy>
+constexpr void List<T, Alloc, LinkPolicy, SizePolicy>::reset_cursors() {
+  for (TruncatedNode* cur = cursors_.next; cur != &cursors_; cur = cur->next) {
+    static_cast<Cursor*>(cur)->node_ = &initial_node_;
+  }
+}
+
+template <typename T, typename Alloc, typename LinkPolicy, typename SizePolicy>
+constexpr void List<T, Alloc, LinkPolicy, SizePolicy>::detach_cursors() {
+  for (TruncatedNode* cur = cursors_.next; cur != &cursors_; cur = cur->next) {
+    static_cast<Cursor*>(cur)->release_retired();
+    static_cast<Cursor*>(cur)->list_ = nullptr;
+    static_cast<Cursor*>(cur)->node_ = nullptr;
+  }
+}
+
+class ForwardTruncatedNode {
+ public:
+  ForwardTruncatedNode* next;
+
+  constexpr ForwardTruncatedNode() : next(nullptr) {}
+
+  constexpr explicit ForwardTruncatedNode(ForwardTruncatedNode* next)
+      : next(next) {}
+
+  ~ForwardTruncatedNode() = default;
+};
+
+template <typename T>
+class ForwardNode : public ForwardTruncatedNode {
+ private:
+  T val_;
+
+ public:
+  constexpr ForwardNode() : ForwardTruncatedNode(), val_() {}
+
+  constexpr ForwardNode(const T& val) : ForwardTruncatedNode(), val_(val) {}
+
+  constexpr ForwardNode(T&& val)
+      : ForwardTruncatedNode(), val_(std::move(val)) {}
+
+  ~ForwardNode() = default;
+
+  constexpr T& get_val() { return val_; }
+};
+
+// Singly linked configuration: no prev pointers and no embedded sentinel,
+// the list is a head/tail pair and end() is the null node. Supports the
+// FIFO subset of the interface with forward iterators.
+template <typename T, typename Alloc, typename SizePolicy>
+class List<T, Alloc, Links::Single, SizePolicy> {
+ private:
+  ForwardTruncatedNode* head_ = nullptr;
+  ForwardTruncatedNode* tail_ = nullptr;
+  [[no_unique_address]] SizeCounter<SizePolicy> size_;
+
+  Alloc list_alloc_;
+  using alloc_traits = std::allocator_traits<Alloc>;
+  typename alloc_traits::template rebind_alloc<ForwardNode<T>> node_alloc_;
+  using node_alloc_traits =
+      typename alloc_traits::template rebind_traits<ForwardNode<T>>;
+
+  template <typename... Args>
+  constexpr ForwardNode<T>* create_node(Args&&... args) {
+    ForwardNode<T>* node = node_alloc_traits::allocate(node_alloc_, 1);
+
+    try {
+      node_alloc_traits::construct(node_alloc_, node,
+                                   std::forward<Args>(args)...);
+    } catch (...) {
+      node_alloc_traits::deallocate(node_alloc_, node, 1);
+      throw;
+    }
+
+    return node;
+  }
+
+  constexpr void destroy_node(ForwardTruncatedNode* node) {
+    node_alloc_traits::destroy(node_alloc_, static_cast<ForwardNode<T>*>(node));
+    node_alloc_traits::deallocate(node_alloc_,
+                                  static_cast<ForwardNode<T>*>(node), 1);
+  }
+
+  constexpr void link_back(ForwardTruncatedNode* node) {
+    if (tail_ == nullptr) {
+      head_ = node;
+    } else {
+      tail_->next = node;
+    }
+    tail_ = node;
+    size_.add(1);
+  }
+
+  constexpr bool node_alloc_equals(const List& other) const {
+    if constexpr (node_alloc_traits::is_always_equal::value) {
+      return true;
+    } else {
+      return node_alloc_ == other.node_alloc_;
+    }
+  }
+
+ public:
+  template <bool IsConst>
+  class Iterator;
+
+  using value_type = T;
+  using allocator_type = Alloc;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  List() = default;
+
+  explicit constexpr List(const Alloc& alloc)
+      : list_alloc_(alloc), node_alloc_(alloc) {}
+
+  constexpr List(size_t count, const T& value, const Alloc& alloc = Alloc())
+      : List(alloc) {
+    try {
+      for (size_t i = 0; i < count; i++) {
+        link_back(create_node(value));
+      }
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+
+  explicit constexpr List(size_t count, const Alloc& alloc = Alloc())
+      : List(alloc) {
+    try {
+      for (size_t i = 0; i < count; i++) {
+        link_back(create_node());
+      }
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+
+  constexpr List(std::initializer_list<T> init, const Alloc& alloc = Alloc())
+      : List(alloc) {
+    push_back_n(init.begin(), init.end());
+  }
+
+  constexpr List(const List& other)
+      : list_alloc_(alloc_traits::select_on_container_copy_construction(
+            other.list_alloc_)),
+        node_alloc_(alloc_traits::select_on_container_copy_construction(
+            other.node_alloc_)) {
+    push_back_n(other.begin(), other.end());
+  }
+
+  constexpr List(List&& other) noexcept
+      : head_(other.head_),
+        tail_(other.tail_),
+        size_(other.size_),
+        list_alloc_(other.list_alloc_),
+        node_alloc_(other.node_alloc_) {
+    other.head_ = nullptr;
+    other.tail_ = nullptr;
+    other.size_.reset();
+  }
+
+  constexpr List& operator=(const List& other) {
+    if (this == &other) {
+      return *this;
+    }
+
+    constexpr bool kPropagate =
+        node_alloc_traits::propagate_on_container_copy_assignment::value;
+
+    List temp(kPropagate ? other.list_alloc_ : list_alloc_);
+    temp.push_back_n(other.begin(), other.end());
+
+    std::swap(head_, temp.head_);
+    std::swap(tail_, temp.tail_);
+    std::swap(size_, temp.size_);
+
+    if constexpr (kPropagate) {
+      std::swap(list_alloc_, temp.list_alloc_);
+      std::swap(node_alloc_, temp.node_alloc_);
+    }
+
+    return *this;
+  }
+
+  // Steals other's nodes when the allocator propagates or compares equal,
+  // otherwise moves the elements over into a chain of this list's nodes.
+  constexpr List& operator=(List&& other) {
+    if (this == &other) {
+      return *this;
+    }
+
+    constexpr bool kPropagate =
+        node_alloc_traits::propagate_on_container_move_assignment::value;
+
+    if (kPropagate || node_alloc_equals(other)) {
+      clear();
+      std::swap(head_, other.head_);
+      std::swap(tail_, other.tail_);
+      std::swap(size_, other.size_);
+
+      if constexpr (kPropagate) {
+        list_alloc_ = other.list_alloc_;
+        node_alloc_ = other.node_alloc_;
+      }
+    } else {
+      List temp(list_alloc_);
+      temp.push_back_n(std::make_move_iterator(other.begin()),
+                       std::make_move_iterator(other.end()));
+      other.clear();
+      clear();
+      std::swap(head_, temp.head_);
+      std::swap(tail_, temp.tail_);
+      std::swap(size_, temp.size_);
+    }
+
+    return *this;
+  }
+
+  constexpr ~List() { clear(); }
+
+  constexpr size_t size() const
+    requires SizeCounter<SizePolicy>::kTracked
+  {
+    return size_.get();
+  }
+
+  constexpr bool empty() const { return head_ == nullptr; }
+
+  constexpr Alloc get_allocator() const { return list_alloc_; }
+
+  constexpr void clear() {
+    while (head_ != nullptr) {
+      ForwardTruncatedNode* next = head_->next;
+      destroy_node(head_);
+      head_ = next;
+    }
+
+    tail_ = nullptr;
+    size_.reset();
+  }
+
+  constexpr T& front() {
+    return static_cast<ForwardNode<T>*>(head_)->get_val();
+  }
+
+  constexpr const T& front() const {
+    return static_cast<ForwardNode<T>*>(head_)->get_val();
+  }
+
+  constexpr T& back() {
+    return static_cast<ForwardNode<T>*>(tail_)->get_val();
+  }
+
+  constexpr const T& back() const {
+    return static_cast<ForwardNode<T>*>(tail_)->get_val();
+  }
+
+  constexpr void push_back(const T& val) { link_back(create_node(val)); }
+
+  constexpr void push_back(T&& val) { link_back(create_node(std::move(val))); }
+
+  constexpr void push_front(const T& val) {
+    ForwardTruncatedNode* node = create_node(val);
+    node->next = head_;
+    head_ = node;
+    if (tail_ == nullptr) {
+      tail_ = node;
+    }
+    size_.add(1);
+  }
+
+  constexpr void push_front(T&& val) {
+    ForwardTruncatedNode* node = create_node(std::move(val));
+    node->next = head_;
+    head_ = node;
+    if (tail_ == nullptr) {
+      tail_ = node;
+    }
+    size_.add(1);
+  }
+
+  // Same contract as the doubly linked push_back_n: all or nothing.
+  template <typename InputIt>
+  constexpr void push_back_n(InputIt first, InputIt last) {
+    ForwardTruncatedNode* chain_first = nullptr;
+    ForwardTruncatedNode* chain_last = nullptr;
+    size_t count = 0;
+
+    try {
+      for (; first != last; ++first, count++) {
+        ForwardTruncatedNode* node = create_node(*first);
+        if (chain_last == nullptr) {
+          chain_first = node;
+        } else {
+          chain_last->next = node;
+        }
+        chain_last = node;
+      }
+    } catch (...) {
+      while (chain_first != nullptr) {
+        ForwardTruncatedNode* next = chain_first->next;
+        destroy_node(chain_first);
+        chain_first = next;
+      }
+      throw;
+    }
+
+    if (count == 0) {
+      return;
+    }
+
+    if (tail_ == nullptr) {
+      head_ = chain_first;
+    } else {
+      tail_->next = chain_first;
+    }
+    tail_ = chain_last;
+    size_.add(count);
+  }
+
+  constexpr void append(List&& other) {
+    if (other.empty()) {
+      return;
+    }
+
+    if (!node_alloc_equals(other)) {
+      for (T& val : other) {
+        push_back(std::move(val));
+      }
+      other.clear();
+      return;
+    }
+
+    if (tail_ == nullptr) {
+      head_ = other.head_;
+    } else {
+      tail_->next = other.head_;
+    }
+    tail_ = other.tail_;
+    size_.take(other.size_);
+
+    other.head_ = nullptr;
+    other.tail_ = nullptr;
+  }
+
+  template <typename OutputIt>
+  constexpr OutputIt pop_front_n(size_t n, OutputIt out) {
+    for (size_t i = 0; i < n && head_ != nullptr; i++) {
+      *out = std::move(front());
+      ++out;
+      pop_front();
+    }
+    return out;
+  }
+
+  constexpr void pop_front() noexcept {
+    ForwardTruncatedNode* node = head_;
+    head_ = head_->next;
+    if (head_ == nullptr) {
+      tail_ = nullptr;
+    }
+
+    destroy_node(node);
+    size_.sub(1);
+  }
+
+  constexpr iterator begin() { return iterator(head_); }
+
+  constexpr iterator end() { return iterator(nullptr); }
+
+  constexpr const_iterator begin() const { return const_iterator(head_); }
+
+  constexpr const_iterator end() const { return const_iterator(nullptr); }
+
+  constexpr const_iterator cbegin() const { return const_iterator(head_); }
+
+  constexpr const_iterator cend() const { return const_iterator(nullptr); }
+};
+
+template <typename T, typename Alloc, typename SizePolicy>
+template <bool IsConst>
+class List<T, Alloc, Links::Single, SizePolicy>::Iterator {
+ private:
+  ForwardTruncatedNode* cur_node_ = nullptr;
+
+ public:
+  using is_const = std::conditional_t<IsConst, const T, T>;
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::remove_cv_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = is_const*;
+  using reference = is_const&;
+
+  Iterator() = default;
+
+  constexpr Iterator(ForwardTruncatedNode* node) : cur_node_(node) {}
+
+  ~Iterator() = default;
+
+  constexpr Iterator& operator++() {
+    cur_node_ = cur_node_->next;
+    return *this;
+  }
+
+  constexpr Iterator operator++(int) {
+    auto temp(*this);
+    ++*this;
+    return temp;
+  }
+
+  constexpr reference operator*() const {
+    return static_cast<ForwardNode<T>*>(cur_node_)->get_val();
+  }
+
+  constexpr pointer operator->() const {
+    return &(static_cast<ForwardNode<T>*>(cur_node_)->get_val());
+  }
+
+  constexpr bool operator==(const Iterator<IsConst>& other) const {
+    return cur_node_ == other.cur_node_;
+  }
+
+  constexpr bool operator!=(const Iterator<IsConst>& other) const {
+    return cur_node_ != other.cur_node_;
+  }
+};
+
+
+class XorTruncatedNode {
+ public:
+  uintptr_t link;
+
+  XorTruncatedNode() : link(0) {}
+
+  ~XorTruncatedNode() = default;
+
+  static uintptr_t address(XorTruncatedNode* node) {
+    return reinterpret_cast<uintptr_t>(node);
+  }
+
+  // Given one neighbour, returns the other one.
+  XorTruncatedNode* other(XorTruncatedNode* neighbour) const {
+    return reinterpret_cast<XorTruncatedNode*>(link ^ address(neighbour));
+  }
+
+  void relink(XorTruncatedNode* old_neighbour,
+              XorTruncatedNode* new_neighbour) {
+    link ^= address(old_neighbour) ^ address(new_neighbour);
+  }
+};
+
+template <typename T>
+class XorNode : public XorTruncatedNode {
+ private:
+  T val_;
+
+ public:
+  XorNode() : XorTruncatedNode(), val_() {}
+
+  XorNode(const T& val) : XorTruncatedNode(), val_(val) {}
+
+  XorNode(T&& val) : XorTruncatedNode(), val_(std::move(val)) {}
+
+  ~XorNode() = default;
+
+  T& get_val() { return val_; }
+};
+
+// Compact doubly linked configuration: every node stores prev ^ next in a
+// single word. The list is a null-terminated head/tail pair and iterators
+// carry the pair of adjacent nodes they need to step in either direction.
+// Since the encoding is symmetric, reverse iteration is forward iteration
+// started from the tail.
+template <typename T, typename Alloc, typename SizePolicy>
+class List<T, Alloc, Links::Xor, SizePolicy> {
+ private:
+  XorTruncatedNode* head_ = nullptr;
+  XorTruncatedNode* tail_ = nullptr;
+  [[no_unique_address]] SizeCounter<SizePolicy> size_;
+
+  Alloc list_alloc_;
+  using alloc_traits = std::allocator_traits<Alloc>;
+  typename alloc_traits::template rebind_alloc<XorNode<T>> node_alloc_;
+  using node_alloc_traits =
+      typename alloc_traits::template rebind_traits<XorNode<T>>;
+
+  template <typename... Args>
+  XorNode<T>* create_node(Args&&... args) {
+    XorNode<T>* node = node_alloc_traits::allocate(node_alloc_, 1);
+
+    try {
+      node_alloc_traits::construct(node_alloc_, node,
+                                   std::forward<Args>(args)...);
+    } catch (...) {
+      node_alloc_traits::deallocate(node_alloc_, node, 1);
+      throw;
+    }
+
+    return node;
+  }
+
+  void destroy_node(XorTruncatedNode* node) {
+    node_alloc_traits::destroy(node_alloc_, static_cast<XorNode<T>*>(node));
+    node_alloc_traits::deallocate(node_alloc_, static_cast<XorNode<T>*>(node),
+                                  1);
+  }
+
+  // Links node past the end that currently is *end, head_ or tail_.
+  static void link_outer(XorTruncatedNode*& end, XorTruncatedNode*& other_end,
+                         XorTruncatedNode* node) {
+    node->link = XorTruncatedNode::address(end);
+    if (end == nullptr) {
+      other_end = node;
+    } else {
+      end->relink(nullptr, node);
+    }
+    end = node;
+  }
+
+  bool node_alloc_equals(const List& other) const {
+    if constexpr (node_alloc_traits::is_always_equal::value) {
+      return true;
+    } else {
+      return node_alloc_ == other.node_alloc_;
+    }
+  }
+
+  void unlink_outer(XorTruncatedNode*& end, XorTruncatedNode*& other_end) {
+    XorTruncatedNode* node = end;
+    end = node->other(nullptr);
+    if (end == nullptr) {
+      other_end = nullptr;
+    } else {
+      end->relink(node, nullptr);
+    }
+
+    destroy_node(node);
+    size_.sub(1);
+  }
+
+ public:
+  template <bool IsConst>
+  class Iterator;
+
+  using value_type = T;
+  using allocator_type = Alloc;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = Iterator<false>;
+  using const_reverse_iterator = Iterator<true>;
+
+  List() = default;
+
+  explicit List(const Alloc& alloc) : list_alloc_(alloc), node_alloc_(alloc) {}
+
+  List(size_t count, const T& value, const Alloc& alloc = Alloc())
+      : List(alloc) {
+    try {
+      for (size_t i = 0; i < count; i++) {
+        push_back(value);
+      }
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+
+  explicit List(size_t count, const Alloc& alloc = Alloc()) : List(alloc) {
+    try {
+      for (size_t i = 0; i < count; i++) {
+        link_outer(tail_, head_, create_node());
+        size_.add(1);
+      }
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+
+  List(std::initializer_list<T> init, const Alloc& alloc = Alloc())
+      : List(alloc) {
+    try {
+      for (const T& val : init) {
+        push_back(val);
+      }
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+
+  List(const List& other)
+      : list_alloc_(alloc_traits::select_on_container_copy_construction(
+            other.list_alloc_)),
+        node_alloc_(alloc_traits::select_on_container_copy_construction(
+            other.node_alloc_)) {
+    try {
+      for (const T& val : other) {
+        push_back(val);
+      }
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+
+  List(List&& other) noexcept
+      : head_(other.head_),
+        tail_(other.tail_),
+        size_(other.size_),
+        list_alloc_(other.list_alloc_),
+        node_alloc_(other.node_alloc_) {
+    other.head_ = nullptr;
+    other.tail_ = nullptr;
+    other.size_.reset();
+  }
+
+  List& operator=(const List& other) {
+    if (this == &other) {
+      return *this;
+    }
+
+    constexpr bool kPropagate =
+        node_alloc_traits::propagate_on_container_copy_assignment::value;
+
+    List temp(kPropagate ? other.list_alloc_ : list_alloc_);
+    for (const T& val : other) {
+      temp.push_back(val);
+    }
+
+    std::swap(head_, temp.head_);
+    std::swap(tail_, temp.tail_);
+    std::swap(size_, temp.size_);
+
+    if constexpr (kPropagate) {
+      std::swap(list_alloc_, temp.list_alloc_);
+      std::swap(node_alloc_, temp.node_alloc_);
+    }
+
+    return *this;
+  }
+
+  // Steals other's nodes when the allocator propagates or compares equal,
+  // otherwise moves the elements into nodes of this list's allocator.
+  List& operator=(List&& other) {
+    if (this == &other) {
+      return *this;
+    }
+
+    constexpr bool kPropagate =
+        node_alloc_traits::propagate_on_container_move_assignment::value;
+
+    if (kPropagate || node_alloc_equals(other)) {
+      clear();
+      std::swap(head_, other.head_);
+      std::swap(tail_, other.tail_);
+      std::swap(size_, other.size_);
+
+      if constexpr (kPropagate) {
+        list_alloc_ = other.list_alloc_;
+        node_alloc_ = other.node_alloc_;
+      }
+    } else {
+      List temp(list_alloc_);
+      for (T& val : other) {
+        temp.push_back(std::move(val));
+      }
+      other.clear();
+      clear();
+      std::swap(head_, temp.head_);
+      std::swap(tail_, temp.tail_);
+      std::swap(size_, temp.size_);
+    }
+
+    return *this;
+  }
+
+  ~List() { clear(); }
+
+  size_t size() const
+    requires SizeCounter<SizePolicy>::kTracked
+  {
+    return size_.get();
+  }
+
+  bool empty() const { return head_ == nullptr; }
+
+  Alloc get_allocator() const { return list_alloc_; }
+
+  void clear() {
+    XorTruncatedNode* prev = nullptr;
+    while (head_ != nullptr) {
+      XorTruncatedNode* next = head_->other(prev);
+      prev = head_;
+      destroy_node(head_);
+      head_ = next;
+    }
+
+    tail_ = nullptr;
+    size_.reset();
+  }
+
+  T& front() { return static_cast<XorNode<T>*>(head_)->get_val(); }
+
+  const T& front() const { return static_cast<XorNode<T>*>(head_)->get_val(); }
+
+  T& back() { return static_cast<XorNode<T>*>(tail_)->get_val(); }
+
+  const T& back() const { return static_cast<XorNode<T>*>(tail_)->get_val(); }
+
+  void push_back(const T& val) {
+    link_outer(tail_, head_, create_node(val));
+    size_.add(1);
+  }
+
+  void push_back(T&& val) {
+    link_outer(tail_, head_, create_node(std::move(val)));
+    size_.add(1);
+  }
+
+  void push_front(const T& val) {
+    link_outer(head_, tail_, create_node(val));
+    size_.add(1);
+  }
+
+  void push_front(T&& val) {
+    link_outer(head_, tail_, create_node(std::move(val)));
+    size_.add(1);
+  }
+
+  void pop_back() noexcept { unlink_outer(tail_, head_); }
+
+  void pop_front() noexcept { unlink_outer(head_, tail_); }
+
+  iterator begin() { return iterator(nullptr, head_); }
+
+  iterator end() { return iterator(tail_, nullptr); }
+
+  const_iterator begin() const { return const_iterator(nullptr, head_); }
+
+  const_iterator end() const { return const_iterator(tail_, nullptr); }
+
+  const_iterator cbegin() const { return begin(); }
+
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return reverse_iterator(nullptr, tail_); }
+
+  reverse_iterator rend() { return reverse_iterator(head_, nullptr); }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(nullptr, tail_);
+  }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(head_, nullptr);
+  }
+
+  const_reverse_iterator crbegin() const { return rbegin(); }
+
+  const_reverse_iterator crend() const { return rend(); }
+};
+
+template <typename T, typename Alloc, typename SizePolicy>
+template <bool IsConst>
+class List<T, Alloc, Links::Xor, SizePolicy>::Iterator {
+ private:
+  XorTruncatedNode* prev_node_ = nullptr;
+  XorTruncatedNode* cur_node_ = nullptr;
+
+ public:
+  using is_const = std::conditional_t<IsConst, const T, T>;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = std::remove_cv_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = is_const*;
+  using reference = is_const&;
+
+  Iterator() = default;
+
+  Iterator(XorTruncatedNode* prev, XorTruncatedNode* cur)
+      : prev_node_(prev), cur_node_(cur) {}
+
+  ~Iterator() = default;
+
+  Iterator& operator++() {
+    XorTruncatedNode* next = cur_node_->other(prev_node_);
+    prev_node_ = cur_node_;
+    cur_node_ = next;
+    return *this;
+  }
+
+  Iterator operator++(int) {
+    auto temp(*this);
+    ++*this;
+    return temp;
+  }
+
+  Iterator& operator--() {
+    XorTruncatedNode* prev = prev_node_->other(cur_node_);
+    cur_node_ = prev_node_;
+    prev_node_ = prev;
+    return *this;
+  }
+
+  Iterator operator--(int) {
+    auto temp(*this);
+    --*this;
+    return temp;
+  }
+
+  reference operator*() const {
+    return static_cast<XorNode<T>*>(cur_node_)->get_val();
+  }
+
+  pointer operator->() const {
+    return &(static_cast<XorNode<T>*>(cur_node_)->get_val());
+  }
+
+  bool operator==(const Iterator<IsConst>& other) const {
+    return cur_node_ == other.cur_node_;
+  }
+
+  bool operator!=(const Iterator<IsConst>& other) const {
+    return cur_node_ != other.cur_node_;
+  }
+};
+
+
+namespace pmr {
+
+template <typename T, typename LinkPolicy = Links::Double,
+          typename SizePolicy = Size::Tracked>
+using List =
+    ::List<T, std::pmr::polymorphic_allocator<T>, LinkPolicy, SizePolicy>;
+
+}  // namespace pmr
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include "list.hpp"
+
+template <typename K, typename V>
+class LruNode : public TruncatedNode {
+ public:
+  size_t hash;
+  K key;
+  V value;
+
+  template <typename KeyArg, typename ValueArg>
+  LruNode(size_t hash, KeyArg&& key, ValueArg&& value)
+      : TruncatedNode(),
+        hash(hash),
+        key(std::forward<KeyArg>(key)),
+        value(std::forward<ValueArg>(value)) {}
+
+  ~LruNode() = default;
+};
+
+// Fixed-capacity LRU cache. Entries are nodes of an intrusive recency list
+// (most recent first) carved from one block allocated up front, and the key
+// index is a flat open-addressing table of node pointers with linear probing
+// and backward-shift deletion. A hit relinks its node to the front in O(1);
+// a miss on a full cache evicts the back node and reuses it for the new
+// entry, so the allocator is only called in the constructor.
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>,
+          typename Alloc = std::allocator<std::pair<const K, V>>>
+class LruCache {
+ private:
+  using Entry = LruNode<K, V>;
+
+  TruncatedNode recency_;
+  TruncatedNode* free_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+
+  Hash hash_;
+  KeyEqual key_equal_;
+
+  using alloc_traits = std::allocator_traits<Alloc>;
+  typename alloc_traits::template rebind_alloc<Entry> node_alloc_;
+  using node_alloc_traits =
+      typename alloc_traits::template rebind_traits<Entry>;
+  typename alloc_traits::template rebind_alloc<Entry*> slot_alloc_;
+  using slot_alloc_traits =
+      typename alloc_traits::template rebind_traits<Entry*>;
+
+  Entry* nodes_ = nullptr;
+  Entry** slots_ = nullptr;
+  size_t slot_mask_ = 0;
+
+  static Entry* as_entry(TruncatedNode* node) {
+    return static_cast<Entry*>(node);
+  }
+
+  // Spreads the low-entropy std::hash of integers over the whole word.
+  size_t hash_of(const K& key) const {
+    size_t hash = hash_(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+  size_t find_slot(const K& key, size_t hash) const {
+    size_t slot = hash & slot_mask_;
+    while (slots_[slot] != nullptr) {
+      if (slots_[slot]->hash == hash && key_equal_(slots_[slot]->key, key)) {
+        return slot;
+      }
+      slot = (slot + 1) & slot_mask_;
+    }
+    return slot;
+  }
+
+  void erase_slot(size_t slot) {
+    size_t next = slot;
+    while (true) {
+      next = (next + 1) & slot_mask_;
+      if (slots_[next] == nullptr) {
+        break;
+      }
+
+      size_t ideal = slots_[next]->hash & slot_mask_;
+      bool movable = (next > slot) ? (ideal <= slot || ideal > next)
+                                   : (ideal <= slot && ideal > next);
+      if (movable) {
+        slots_[slot] = slots_[next];
+        slot = next;
+      }
+    }
+    slots_[slot] = nullptr;
+  }
+
+  void link_front(TruncatedNode* node) {
+    TruncatedNode::link_before(recency_.next, node);
+  }
+
+  // A free slot holds a bare TruncatedNode constructed in the entry's
+  // storage, so the free stack never writes through a dead Entry.
+  void push_free(Entry* storage) {
+    free_ = std::construct_at(
+        static_cast<TruncatedNode*>(static_cast<void*>(storage)), free_,
+        nullptr);
+  }
+
+  Entry* pop_free() {
+    TruncatedNode* slot = free_;
+    free_ = slot->next;
+    std::destroy_at(slot);
+    return static_cast<Entry*>(static_cast<void*>(slot));
+  }
+
+  void release(Entry* node) {
+    node_alloc_traits::destroy(node_alloc_, node);
+    push_free(node);
+  }
+
+  template <typename KeyArg, typename ValueArg>
+  Entry* insert_new(size_t slot, size_t hash, KeyArg&& key,
+                    ValueArg&& value) {
+    Entry* node = nullptr;
+
+    if (free_ != nullptr) {
+      node = pop_free();
+
+      try {
+        node_alloc_traits::construct(node_alloc_, node, hash,
+                                     std::forward<KeyArg>(key),
+                                     std::forward<ValueArg>(value));
+      } catch (...) {
+        push_free(node);
+        throw;
+      }
+      size_++;
+    } else {
+      node = as_entry(recency_.prev);
+      TruncatedNode::unlink(node);
+      erase_slot(find_slot(node->key, node->hash));
+      slot = find_slot(key, hash);
+
+      try {
+        node->key = std::forward<KeyArg>(key);
+        node->value = std::forward<ValueArg>(value);
+      } catch (...) {
+        release(node);
+        size_--;
+        throw;
+      }
+      node->hash = hash;
+    }
+
+    slots_[slot] = node;
+    link_front(node);
+    return node;
+  }
+
+  template <typename ValueArg>
+  V& put_impl(const K& key, ValueArg&& value) {
+    size_t hash = hash_of(key);
+    size_t slot = find_slot(key, hash);
+
+    if (slots_[slot] != nullptr) {
+      Entry* node = slots_[slot];
+      node->value = std::forward<ValueArg>(value);
+      TruncatedNode::unlink(node);
+      link_front(node);
+      return node->value;
+    }
+
+    return insert_new(slot, hash, key, std::forward<ValueArg>(value))->value;
+  }
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using allocator_type = Alloc;
+
+  explicit LruCache(size_t capacity, const Hash& hash = Hash(),
+                    const KeyEqual& key_equal = KeyEqual(),
+                    const Alloc& alloc = Alloc())
+      : capacity_(capacity),
+        hash_(hash),
+        key_equal_(key_equal),
+        node_alloc_(alloc),
+        slot_alloc_(alloc) {
+    if (capacity_ == 0) {
+      return;
+    }
+
+    size_t slot_count = 2;
+    while (slot_count < 2 * capacity_) {
+      slot_count *= 2;
+    }
+    slot_mask_ = slot_count - 1;
+
+    nodes_ = node_alloc_traits::allocate(node_alloc_, capacity_);
+    try {
+      slots_ = slot_alloc_traits::allocate(slot_alloc_, slot_count);
+    } catch (...) {
+      node_alloc_traits::deallocate(node_alloc_, nodes_, capacity_);
+      throw;
+    }
+    std::fill(slots_, slots_ + slot_count, nullptr);
+
+    for (size_t i = capacity_; i > 0; i--) {
+      push_free(nodes_ + (i - 1));
+    }
+  }
+
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  ~LruCache() {
+    clear();
+
+    if (capacity_ != 0) {
+      node_alloc_traits::deallocate(node_alloc_, nodes_, capacity_);
+      slot_alloc_traits::deallocate(slot_alloc_, slots_, slot_mask_ + 1);
+    }
+  }
+
+  size_t size() const { return size_; }
+
+  size_t capacity() const { return capacity_; }
+
+  bool empty() const { return size_ == 0; }
+
+  // Returns the cached value and marks it most recently used, or nullptr.
+  V* get(const K& key) {
+    if (size_ == 0) {
+      return nullptr;
+    }
+
+    Entry* node = slots_[find_slot(key, hash_of(key))];
+    if (node == nullptr) {
+      return nullptr;
+    }
+
+    TruncatedNode::unlink(node);
+    link_front(node);
+    return &node->value;
+  }
+
+  // Like get, but leaves the recency order alone.
+  const V* peek(const K& key) const {
+    if (size_ == 0) {
+      return nullptr;
+    }
+
+    Entry* node = slots_[find_slot(key, hash_of(key))];
+    return node == nullptr ? nullptr : &node->value;
+  }
+
+  bool contains(const K& key) const { return peek(key) != nullptr; }
+
+  // Inserts or overwrites key as the most recently used entry. On a full
+  // cache the least recently used entry is evicted and its node reused.
+  V& put(const K& key, const V& value) {
+    if (capacity_ == 0) {
+      throw std::length_error("LruCache with zero capacity");
+    }
+    return put_impl(key, value);
+  }
+
+  V& put(const K& key, V&& value) {
+    if (capacity_ == 0) {
+      throw std::length_error("LruCache with zero capacity");
+    }
+    return put_impl(key, std::move(value));
+  }
+
+  bool erase(const K& key) {
+    if (size_ == 0) {
+      return false;
+    }
+
+    size_t slot = find_slot(key, hash_of(key));
+    Entry* node = slots_[slot];
+    if (node == nullptr) {
+      return false;
+    }
+
+    erase_slot(slot);
+    TruncatedNode::unlink(node);
+    release(node);
+    size_--;
+    return true;
+  }
+
+  void clear() {
+    while (recency_.next != &recency_) {
+      Entry* node = as_entry(recency_.next);
+      erase_slot(find_slot(node->key, node->hash));
+      TruncatedNode::unlink(node);
+      release(node);
+    }
+    size_ = 0;
+  }
+
+  // Visits entries from the most to the least recently used.
+  template <typename F>
+  void for_each(F func) {
+    for (TruncatedNode* cur = recency_.next; cur != &recency_;
+         cur = cur->next) {
+      func(as_entry(cur)->key, as_entry(cur)->value);
+    }
+  }
+};
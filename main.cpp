@@ -9,4 +9,26 @@ int main() {
   PROPAGATE(); // TODO: fuck dingus
   ACCOUNTANT();
   EXCEPTS();
+  CONCURRENT_LIST();
+  BATCH();
+  BOUNDED();
+  CONSTEXPR();
+  POLICIES();
+  PMR();
+  NOEXCEPT_PUSH();
+  FUZZ_EXCEPTIONS();
+  RANGES();
+  CURSOR();
+  LRU_CACHE();
+  SHARDED();
+  HUGE_PAGES();
+  COMPACT();
+  RCU();
+  ASYNC_CHANNEL();
+  TIMER_WHEEL();
+  PARALLEL_COPY();
+  TRACE();
+  ADAPTIVE();
+  DEFERRED();
+  PROFILING();
 }
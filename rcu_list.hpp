@@ -0,0 +1,387 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "list.hpp"
+
+// Read-mostly list with one writer thread and lock-free readers. Readers
+// only follow next pointers, which the writer publishes with release stores
+// through std::atomic_ref and readers load with acquire; prev pointers are
+// the writer's private business. Unlinked nodes keep their next pointer and
+// are reclaimed after a grace period: every reader announces the epoch it
+// entered in, and a node is freed once no reader has been inside since
+// before it was unlinked.
+//
+// Writer operations must all come from one thread at a time. Readers need
+// a Reader handle each, one per thread, which owns a slot of a fixed table,
+// and iterate inside a Reader::Section.
+//
+// Readers walk with RcuList's own forward const_iterator rather than
+// List's Iterator. List's Iterator reads next with plain loads, which race
+// with the writer's publishing stores. It is also bidirectional, and
+// stepping back follows prev, which readers must not touch. Giving it a
+// load policy would add a template parameter to the iterator of every
+// List configuration for the sake of this one reader.
+template <typename T, typename Alloc = std::allocator<T>>
+class RcuList {
+ private:
+  static constexpr size_t kMaxReaders = 64;
+  static constexpr size_t kReclaimEvery = 1024;
+  static constexpr uint64_t kIdle = 0;
+
+  struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> epoch = kIdle;
+    std::atomic<bool> claimed = false;
+  };
+
+  // Nodes unlinked while the global epoch was epoch, chained through prev.
+  struct Retired {
+    uint64_t epoch;
+    TruncatedNode* first;
+  };
+
+  TruncatedNode head_;
+  std::atomic<size_t> size_ = 0;
+
+  std::atomic<uint64_t> epoch_ = 1;
+  std::array<ReaderSlot, kMaxReaders> readers_;
+
+  std::vector<Retired> retired_;
+  size_t retired_since_reclaim_ = 0;
+
+  Alloc list_alloc_;
+  using alloc_traits = std::allocator_traits<Alloc>;
+  typename alloc_traits::template rebind_alloc<Node<T>> node_alloc_;
+  using node_alloc_traits =
+      typename alloc_traits::template rebind_traits<Node<T>>;
+
+  static TruncatedNode* load_next(TruncatedNode* node) {
+    return std::atomic_ref<TruncatedNode*>(node->next).load(
+        std::memory_order_acquire);
+  }
+
+  static void publish_next(TruncatedNode* node, TruncatedNode* next) {
+    std::atomic_ref<TruncatedNode*>(node->next).store(
+        next, std::memory_order_release);
+  }
+
+  static T& value_of(TruncatedNode* node) {
+    return static_cast<Node<T>*>(node)->get_val();
+  }
+
+  template <typename... Args>
+  Node<T>* create_node(Args&&... args) {
+    Node<T>* node = node_alloc_traits::allocate(node_alloc_, 1);
+    try {
+      node_alloc_traits::construct(node_alloc_, node, std::in_place,
+                                   std::forward<Args>(args)...);
+    } catch (...) {
+      node_alloc_traits::deallocate(node_alloc_, node, 1);
+      throw;
+    }
+    return node;
+  }
+
+  void destroy_node(TruncatedNode* node) {
+    node_alloc_traits::destroy(node_alloc_, static_cast<Node<T>*>(node));
+    node_alloc_traits::deallocate(node_alloc_, static_cast<Node<T>*>(node),
+                                  1);
+  }
+
+  // The node is fully built before the release store makes it reachable.
+  void link_before(TruncatedNode* pos, TruncatedNode* node) {
+    TruncatedNode* pred = pos->prev;
+    node->next = pos;
+    node->prev = pred;
+    pos->prev = node;
+    publish_next(pred, node);
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // The retired batch is set up first, so a throwing push_back leaves the
+  // node linked.
+  void unlink(TruncatedNode* node) {
+    uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+    if (retired_.empty() || retired_.back().epoch != epoch) {
+      retired_.push_back({epoch, nullptr});
+    }
+
+    TruncatedNode* pred = node->prev;
+    publish_next(pred, node->next);
+    node->next->prev = pred;
+    size_.fetch_sub(1, std::memory_order_relaxed);
+
+    node->prev = retired_.back().first;
+    retired_.back().first = node;
+
+    if (++retired_since_reclaim_ >= kReclaimEvery) {
+      reclaim();
+    }
+  }
+
+  // Oldest epoch a reader is still inside, or the current one when idle.
+  uint64_t oldest_active(uint64_t current) const {
+    uint64_t oldest = current;
+    for (const ReaderSlot& slot : readers_) {
+      uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+      if (epoch != kIdle && epoch < oldest) {
+        oldest = epoch;
+      }
+    }
+    return oldest;
+  }
+
+  void free_retired_before(uint64_t epoch) {
+    size_t freed = 0;
+    while (freed < retired_.size() && retired_[freed].epoch < epoch) {
+      TruncatedNode* cur = retired_[freed].first;
+      while (cur != nullptr) {
+        TruncatedNode* next = cur->prev;
+        destroy_node(cur);
+        cur = next;
+      }
+      freed++;
+    }
+    retired_.erase(retired_.begin(), retired_.begin() + freed);
+  }
+
+ public:
+  using value_type = T;
+  using allocator_type = Alloc;
+
+  class Reader;
+
+  // Forward iterator for readers. Only valid inside the Reader::Section it
+  // came from; advancing loads next with acquire, so it sees every node the
+  // writer had finished building when it was published.
+  class const_iterator {
+   private:
+    TruncatedNode* node_ = nullptr;
+
+    friend class RcuList;
+
+    explicit const_iterator(TruncatedNode* node) : node_(node) {}
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() = default;
+
+    reference operator*() const { return value_of(node_); }
+
+    pointer operator->() const { return &value_of(node_); }
+
+    const_iterator& operator++() {
+      node_ = load_next(node_);
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const const_iterator&) const = default;
+  };
+
+  explicit RcuList(const Alloc& alloc = Alloc())
+      : list_alloc_(alloc), node_alloc_(alloc) {}
+
+  RcuList(const RcuList&) = delete;
+  RcuList& operator=(const RcuList&) = delete;
+
+  // No reader may be inside the list any more.
+  ~RcuList() {
+    TruncatedNode* cur = head_.next;
+    while (cur != &head_) {
+      TruncatedNode* next = cur->next;
+      destroy_node(cur);
+      cur = next;
+    }
+    free_retired_before(static_cast<uint64_t>(-1));
+  }
+
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  bool empty() const { return size() == 0; }
+
+  Alloc get_allocator() const { return list_alloc_; }
+
+  // Writer side.
+
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    link_before(&head_, create_node(std::forward<Args>(args)...));
+  }
+
+  template <typename... Args>
+  void emplace_front(Args&&... args) {
+    link_before(head_.next, create_node(std::forward<Args>(args)...));
+  }
+
+  void push_back(const T& val) { emplace_back(val); }
+
+  void push_back(T&& val) { emplace_back(std::move(val)); }
+
+  void push_front(const T& val) { emplace_front(val); }
+
+  void push_front(T&& val) { emplace_front(std::move(val)); }
+
+  void pop_front() { unlink(head_.next); }
+
+  void pop_back() { unlink(head_.prev); }
+
+  // Unlinks every element matching pred, returns how many.
+  template <typename Pred>
+  size_t erase_if(Pred pred) {
+    size_t erased = 0;
+    TruncatedNode* cur = head_.next;
+    while (cur != &head_) {
+      TruncatedNode* next = cur->next;
+      if (pred(value_of(cur))) {
+        unlink(cur);
+        erased++;
+      }
+      cur = next;
+    }
+    return erased;
+  }
+
+  void clear() {
+    erase_if([](const T&) { return true; });
+  }
+
+  // Starts a grace period and frees what earlier ones made safe, without
+  // waiting for readers.
+  void reclaim() {
+    retired_since_reclaim_ = 0;
+    uint64_t current = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    free_retired_before(oldest_active(current));
+  }
+
+  // Waits until every reader inside the list has left, then frees all
+  // unlinked nodes.
+  void synchronize() {
+    retired_since_reclaim_ = 0;
+    uint64_t current = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    while (oldest_active(current) < current) {
+      std::this_thread::yield();
+    }
+    free_retired_before(current);
+  }
+
+  // Nodes unlinked but not yet freed; meant for tests.
+  size_t retired_count() const {
+    size_t count = 0;
+    for (const Retired& batch : retired_) {
+      for (TruncatedNode* cur = batch.first; cur != nullptr; cur = cur->prev) {
+        count++;
+      }
+    }
+    return count;
+  }
+};
+
+// Per-thread reading handle. Every traversal runs in a read section: the
+// reader publishes the current epoch in its slot and clears it on the way
+// out, which is all the synchronization a reader does. Sections nest; only
+// the outermost one touches the slot.
+template <typename T, typename Alloc>
+class RcuList<T, Alloc>::Reader {
+ private:
+  RcuList* list_;
+  ReaderSlot* slot_ = nullptr;
+  size_t depth_ = 0;
+
+  void enter() {
+    if (depth_++ != 0) {
+      return;
+    }
+    slot_->epoch.store(list_->epoch_.load(std::memory_order_seq_cst),
+                       std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  void leave() {
+    if (--depth_ == 0) {
+      slot_->epoch.store(kIdle, std::memory_order_release);
+    }
+  }
+
+ public:
+  // Pins every node reachable from the list for as long as it lives, so
+  // its begin()/end() can go to range-for and <algorithm>. The writer is
+  // not blocked, but nothing unlinked meanwhile is freed until the section
+  // ends, so keep sections short. A writer thread that holds a section must
+  // not call synchronize(), which would wait for it forever.
+  class Section {
+   private:
+    Reader* reader_;
+
+   public:
+    explicit Section(Reader& reader) : reader_(&reader) { reader_->enter(); }
+
+    Section(const Section&) = delete;
+    Section& operator=(const Section&) = delete;
+
+    ~Section() { reader_->leave(); }
+
+    const_iterator begin() const {
+      return const_iterator(load_next(&reader_->list_->head_));
+    }
+
+    const_iterator end() const {
+      return const_iterator(&reader_->list_->head_);
+    }
+  };
+
+  explicit Reader(RcuList& list) : list_(&list) {
+    for (ReaderSlot& slot : list_->readers_) {
+      bool expected = false;
+      if (slot.claimed.compare_exchange_strong(expected, true)) {
+        slot_ = &slot;
+        return;
+      }
+    }
+    throw std::length_error("RcuList reader slots exhausted");
+  }
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  ~Reader() { slot_->claimed.store(false, std::memory_order_release); }
+
+  Section section() { return Section(*this); }
+
+  // func must not call back into the writer side.
+  template <typename F>
+  void for_each(F func) {
+    Section section(*this);
+    for (const T& val : section) {
+      func(val);
+    }
+  }
+
+  template <typename Pred>
+  bool any_of(Pred pred) {
+    Section section(*this);
+    return std::any_of(section.begin(), section.end(), pred);
+  }
+
+  bool contains(const T& val) {
+    return any_of([&val](const T& x) { return x == val; });
+  }
+};
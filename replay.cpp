@@ -0,0 +1,192 @@
+// Replays a ListTrace against List under several allocator and policy
+// configurations and reports throughput and allocation counts.
+//
+//   replay TRACE [REPEAT]   replay a trace saved by ListTrace::save
+//   replay --demo FILE      record a synthetic queue-and-scan trace to FILE
+//   replay                  replay the synthetic trace without saving it
+//
+// Elements are stand-ins of the recorded element size, rounded up to the
+// next of 8, 16, 32, 64, 128 or 256 bytes. Pops of elements the trace
+// never pushed, from a list traced after it was filled, are skipped and
+// counted. Singly linked lists replay pop_back as pop_front.
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string>
+
+#include "huge_page_allocator.hpp"
+#include "list.hpp"
+#include "memory_utils.hpp"
+#include "trace_list.hpp"
+
+size_t MemoryManager::type_new_allocated = 0;
+size_t MemoryManager::type_new_deleted = 0;
+size_t MemoryManager::allocator_allocated = 0;
+size_t MemoryManager::allocator_deallocated = 0;
+size_t MemoryManager::allocator_constructed = 0;
+size_t MemoryManager::allocator_destroyed = 0;
+
+using ReplayClock = std::chrono::steady_clock;
+
+template <size_t Bytes>
+struct Payload {
+  std::array<unsigned char, Bytes> bytes{};
+};
+
+// Bursty producer/consumer queue with an occasional partial scan, the kind
+// of stream a work queue with a status page produces.
+ListTrace DemoTrace() {
+  ListTrace trace;
+  TracingList<Payload<24>> lst(&trace);
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> burst(1, 64);
+  std::uniform_int_distribution<int> kind(0, 9);
+
+  for (int round = 0; round < 20000; ++round) {
+    int op = kind(gen);
+    if (op < 4) {
+      for (int i = burst(gen); i > 0; --i) {
+        lst.push_back(Payload<24>());
+      }
+    } else if (op < 8) {
+      for (int i = burst(gen); i > 0 && !lst.empty(); --i) {
+        lst.pop_front();
+      }
+    } else if (op == 8) {
+      size_t seen = 0;
+      size_t limit = static_cast<size_t>(burst(gen)) * 4;
+      lst.find_if([&](const Payload<24>&) { return ++seen == limit; });
+    } else if (!lst.empty()) {
+      lst.pop_back();
+    }
+  }
+  return trace;
+}
+
+template <typename ListT>
+double ReplaySeconds(const ListTrace& trace, ListT& lst, size_t& checksum,
+                     size_t& skipped) {
+  auto start = ReplayClock::now();
+  skipped = replay_trace(trace, lst, [&checksum](const auto& val) {
+    checksum += val.bytes[0] + 1;
+  });
+  return std::chrono::duration<double>(ReplayClock::now() - start).count();
+}
+
+template <typename T, typename Alloc, typename LinkPolicy, typename SizePolicy>
+void RunConfig(const std::string& name, const ListTrace& trace, size_t repeat,
+               const Alloc& alloc = Alloc()) {
+  using ListT = List<T, Alloc, LinkPolicy, SizePolicy>;
+  size_t allocated = MemoryManager::allocator_allocated;
+  size_t constructed = MemoryManager::allocator_constructed;
+
+  size_t checksum = 0;
+  size_t skipped = 0;
+  double seconds = 0;
+  for (size_t i = 0; i < repeat; ++i) {
+    ListT lst(alloc);
+    seconds += ReplaySeconds(trace, lst, checksum, skipped);
+  }
+
+  double ops = static_cast<double>(trace.op_count() * repeat);
+  std::cout << name << ": " << ops / seconds / 1e6 << " Mops/s (" << seconds
+            << " s, checksum " << checksum << ")";
+  if (MemoryManager::allocator_constructed != constructed) {
+    std::cout << ", " << (MemoryManager::allocator_constructed - constructed) /
+                             repeat
+              << " nodes / "
+              << (MemoryManager::allocator_allocated - allocated) / repeat
+              << " bytes allocated per replay";
+  }
+  if (skipped != 0) {
+    std::cout << ", skipped " << skipped
+              << " pops of missing elements per replay";
+  }
+  std::cout << '\n';
+}
+
+template <typename T, typename LinkPolicy, typename SizePolicy>
+void RunAllocators(const std::string& policy, const ListTrace& trace,
+                   size_t repeat) {
+  RunConfig<T, AllocatorWithCount<T>, LinkPolicy, SizePolicy>(
+      policy + " counting", trace, repeat);
+  RunConfig<T, std::allocator<T>, LinkPolicy, SizePolicy>(
+      policy + " std::allocator", trace, repeat);
+
+  std::pmr::unsynchronized_pool_resource pool;
+  RunConfig<T, std::pmr::polymorphic_allocator<T>, LinkPolicy, SizePolicy>(
+      policy + " pmr_pool", trace, repeat,
+      std::pmr::polymorphic_allocator<T>(&pool));
+
+  RunConfig<T, HugePageAllocator<T>, LinkPolicy, SizePolicy>(
+      policy + " huge_pages", trace, repeat, HugePageAllocator<T>());
+}
+
+template <size_t Bytes>
+void RunAll(const ListTrace& trace, size_t repeat) {
+  using T = Payload<Bytes>;
+  std::cout << trace.op_count() << " ops in " << trace.byte_size()
+            << " bytes, element " << trace.element_size() << "B replayed as "
+            << Bytes << "B, " << repeat << " replays\n";
+
+  RunAllocators<T, Links::Double, Size::Tracked>("double_tracked", trace,
+                                                 repeat);
+  RunAllocators<T, Links::Double, Size::Untracked>("double_untracked", trace,
+                                                   repeat);
+  RunAllocators<T, Links::Xor, Size::Tracked>("xor_tracked", trace, repeat);
+}
+
+void Dispatch(const ListTrace& trace, size_t repeat) {
+  size_t size = trace.element_size();
+  if (size <= 8) {
+    RunAll<8>(trace, repeat);
+  } else if (size <= 16) {
+    RunAll<16>(trace, repeat);
+  } else if (size <= 32) {
+    RunAll<32>(trace, repeat);
+  } else if (size <= 64) {
+    RunAll<64>(trace, repeat);
+  } else if (size <= 128) {
+    RunAll<128>(trace, repeat);
+  } else {
+    RunAll<256>(trace, repeat);
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string first = argc > 1 ? argv[1] : "";
+
+  if (first == "--demo") {
+    if (argc < 3) {
+      std::cerr << "usage: replay --demo FILE\n";
+      return 1;
+    }
+    std::ofstream out(argv[2], std::ios::binary);
+    DemoTrace().save(out);
+    return out ? 0 : 1;
+  }
+
+  size_t repeat = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+  if (repeat == 0) {
+    repeat = 1;
+  }
+
+  if (first.empty()) {
+    Dispatch(DemoTrace(), repeat);
+    return 0;
+  }
+
+  std::ifstream in(first, std::ios::binary);
+  try {
+    Dispatch(ListTrace::load(in), repeat);
+  } catch (const std::exception& err) {
+    std::cerr << first << ": " << err.what() << '\n';
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "list.hpp"
+
+// Append-mostly list split into one shard per hardware thread. Every shard
+// is a List<T, Alloc> with its own copy of the allocator and its own lock,
+// padded to a cache line so that neighbouring shards never share one. A
+// thread keeps pushing into the shard it was assigned on its first push, so
+// with no more threads than shards the lock is never contended. There is no
+// global order: drain_into splices the shards one after another, and a
+// thread's own elements keep their relative order.
+template <typename T, typename Alloc = std::allocator<T>>
+class ShardedList {
+ private:
+  static constexpr size_t kCacheLine = 64;
+
+  struct alignas(kCacheLine) Shard {
+    std::mutex mutex;
+    List<T, Alloc> list;
+
+    explicit Shard(const Alloc& alloc) : list(alloc) {}
+  };
+
+  Shard* shards_ = nullptr;
+  size_t shard_count_ = 0;
+
+  // Threads are numbered once per process and spread over the shards of
+  // every ShardedList round-robin.
+  static size_t thread_slot() {
+    static std::atomic<size_t> next_slot = 0;
+    thread_local size_t slot =
+        next_slot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+  }
+
+  Shard& local_shard() { return shards_[thread_slot() % shard_count_]; }
+
+ public:
+  using value_type = T;
+  using allocator_type = Alloc;
+
+  explicit ShardedList(size_t shard_count = std::thread::hardware_concurrency(),
+                       const Alloc& alloc = Alloc())
+      : shard_count_(shard_count == 0 ? 1 : shard_count) {
+    shards_ = static_cast<Shard*>(::operator new(
+        sizeof(Shard) * shard_count_, std::align_val_t{alignof(Shard)}));
+
+    size_t built = 0;
+    try {
+      for (; built < shard_count_; ++built) {
+        new (shards_ + built) Shard(alloc);
+      }
+    } catch (...) {
+      std::destroy_n(shards_, built);
+      ::operator delete(shards_, std::align_val_t{alignof(Shard)});
+      throw;
+    }
+  }
+
+  ShardedList(const ShardedList&) = delete;
+  ShardedList& operator=(const ShardedList&) = delete;
+
+  ~ShardedList() {
+    std::destroy_n(shards_, shard_count_);
+    ::operator delete(shards_, std::align_val_t{alignof(Shard)});
+  }
+
+  size_t shard_count() const { return shard_count_; }
+
+  void push_back(const T& val) {
+    Shard& shard = local_shard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.list.push_back(val);
+  }
+
+  void push_back(T&& val) {
+    Shard& shard = local_shard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.list.push_back(std::move(val));
+  }
+
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    Shard& shard = local_shard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.list.emplace_back(std::forward<Args>(args)...);
+  }
+
+  // Sum of the shard sizes; only exact when no thread is pushing.
+  size_t size() {
+    size_t total = 0;
+    for (size_t i = 0; i < shard_count_; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      total += shards_[i].list.size();
+    }
+    return total;
+  }
+
+  bool empty() { return size() == 0; }
+
+  void clear() {
+    for (size_t i = 0; i < shard_count_; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      shards_[i].list.clear();
+    }
+  }
+
+  // Moves every element to the back of out, shard by shard. Nodes are
+  // spliced without copying when out's allocator compares equal to the
+  // shard's, otherwise List::append falls back to moving the elements.
+  void drain_into(List<T, Alloc>& out) {
+    for (size_t i = 0; i < shard_count_; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      out.append(std::move(shards_[i].list));
+    }
+  }
+
+  // Visits the shards in turn, holding one shard lock at a time.
+  template <typename F>
+  void for_each(F func) {
+    for (size_t i = 0; i < shard_count_; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      for (T& val : shards_[i].list) {
+        func(val);
+      }
+    }
+  }
+};
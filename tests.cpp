@@ -1,13 +1,33 @@
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <iostream>
+#include <map>
 #include <numeric>
+#include <optional>
 #include <random>
+#include <ranges>
+#include <sstream>
 #include <tuple>
 #include <type_traits>
 #include <string>
-
+#include <thread>
+#include <vector>
+
+#include "adaptive_list.hpp"
+#include "async_channel.hpp"
+#include "bounded_list.hpp"
+#include "concurrent_list.hpp"
+#include "deferred_list.hpp"
+#include "huge_page_allocator.hpp"
 #include "list.hpp"
+#include "lru_cache.hpp"
+#include "profiling_allocator.hpp"
+#include "rcu_list.hpp"
+#include "sharded_list.hpp"
+#include "thread_executor.hpp"
+#include "timer_wheel.hpp"
+#include "trace_list.hpp"
 //#include "memory_utils.hpp"
 #include "utils.hpp"
 
@@ -38,6 +58,8 @@ size_t Accountant::dtor_calls = 0;
 
 bool ThrowingAccountant::need_throw = false;
 
+size_t FailingAllocatorBudget::allocations_left = SIZE_MAX;
+
 void SetupTest() {
   MemoryManager::type_new_allocated = 0;
   MemoryManager::type_new_deleted = 0;
@@ -211,7 +233,8 @@ void CONSTRUCTOR() {
   {
     SetupTest();
     const size_t size = 5;
-    List<TypeWithCounts, AllocatorWithCount<TypeWithCounts>> l1 = {1, 2, 3, 4, 5};
+    List<TypeWithCounts, AllocatorWithCount<TypeWithCounts>> l1 = {
+        1, 2, 3, 4, 5};
 
     List<TypeWithCounts, AllocatorWithCount<TypeWithCounts>> l2(l1);
 
@@ -395,3 +418,1967 @@ void EXCEPTS() {
      EXPECT_TRUE(lst.size() == 8);
   }
 }
+
+
+void CONCURRENT_LIST() {
+  std::cout << "Checking concurrent list: \n";
+  {
+    ConcurrentSortedList<int> lst;
+
+    EXPECT_TRUE(lst.insert(3));
+    EXPECT_TRUE(lst.insert(1));
+    EXPECT_TRUE(lst.insert(2));
+    EXPECT_FALSE(lst.insert(2));
+    EXPECT_TRUE(lst.size() == 3);
+
+    EXPECT_TRUE(lst.contains(2));
+    EXPECT_TRUE(lst.erase(2));
+    EXPECT_FALSE(lst.contains(2));
+    EXPECT_FALSE(lst.erase(2));
+    EXPECT_TRUE(lst.size() == 2);
+  }
+
+  {
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 500;
+    ConcurrentSortedList<int> lst;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&lst, t] {
+        for (int i = 0; i < kPerThread; ++i) {
+          lst.insert(i * kThreads + t);
+        }
+        for (int i = 0; i < kPerThread; i += 2) {
+          lst.erase(i * kThreads + t);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    EXPECT_TRUE(lst.size() == kThreads * kPerThread / 2);
+
+    std::vector<int> values;
+    lst.for_each([&values](int x) { values.push_back(x); });
+    EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+    EXPECT_TRUE(values.size() == lst.size());
+    EXPECT_TRUE((values.front() / kThreads) % 2 == 1);
+  }
+}
+
+void BATCH() {
+  std::cout << "Checking batch operations: \n";
+  {
+    List<int> lst = {1, 2};
+    std::vector<int> values = {3, 4, 5, 6};
+
+    lst.push_back_n(values.begin(), values.end());
+    EXPECT_TRUE(lst.size() == 6);
+    EXPECT_TRUE(AreListsEqual(lst, List<int>({1, 2, 3, 4, 5, 6})));
+
+    std::vector<int> popped;
+    lst.pop_front_n(4, std::back_inserter(popped));
+    EXPECT_TRUE((popped == std::vector<int>{1, 2, 3, 4}));
+    EXPECT_TRUE(AreListsEqual(lst, List<int>({5, 6})));
+
+    lst.pop_front_n(10, std::back_inserter(popped));
+    EXPECT_TRUE(lst.empty());
+    EXPECT_TRUE(popped.size() == 6);
+
+    lst.push_back(7);
+    EXPECT_TRUE(lst.size() == 1);
+  }
+
+  {
+    List<int> first = {1, 2, 3};
+    List<int> second = {4, 5};
+    const int* fourth = &second.front();
+    const int* fifth = &second.back();
+
+    first.append(std::move(second));
+    EXPECT_TRUE(second.empty());
+    EXPECT_TRUE(AreListsEqual(first, List<int>({1, 2, 3, 4, 5})));
+    EXPECT_TRUE(&*std::next(first.begin(), 3) == fourth &&
+                &first.back() == fifth);
+
+    second.push_back(6);
+    first.append(std::move(second));
+    EXPECT_TRUE(first.size() == 6);
+    EXPECT_TRUE(*first.rbegin() == 6);
+  }
+
+  {
+    SetupTest();
+    List<int, AllocatorWithCount<int>> first = {1, 2};
+    List<int, AllocatorWithCount<int>> second = {3, 4};
+    EXPECT_TRUE(first.get_allocator() == second.get_allocator());
+    size_t allocated = MemoryManager::allocator_allocated;
+    const int* third = &second.front();
+
+    first.append(std::move(second));
+    EXPECT_TRUE(second.empty());
+    EXPECT_TRUE(first.size() == 4);
+    EXPECT_TRUE(MemoryManager::allocator_allocated == allocated &&
+                &*std::next(first.begin(), 2) == third);
+    EXPECT_TRUE(MemoryManager::allocator_constructed ==
+                MemoryManager::allocator_destroyed + 4);
+  }
+
+  {
+    Accountant::reset();
+    ThrowingAccountant::need_throw = true;
+
+    List<ThrowingAccountant> lst;
+    std::vector<ThrowingAccountant> values(3);
+    try {
+      lst.push_back_n(values.begin(), values.end());
+    } catch (...) {
+      EXPECT_TRUE(lst.empty());
+      EXPECT_TRUE(Accountant::ctor_calls == Accountant::dtor_calls + 3);
+    }
+
+    ThrowingAccountant::need_throw = false;
+  }
+}
+
+void BOUNDED() {
+  std::cout << "Checking bounded list: \n";
+  {
+    SetupTest();
+    List<int> expected = {3, 4, 5};
+    {
+      BoundedList<int, AllocatorWithCount<int>> lst(3);
+      size_t allocated = MemoryManager::allocator_allocated;
+
+      for (int i = 1; i <= 5; ++i) {
+        lst.push_back(i);
+      }
+
+      EXPECT_TRUE(lst.full());
+      EXPECT_TRUE(lst.size() == 3);
+      EXPECT_TRUE(AreListsEqual(lst, expected));
+      EXPECT_TRUE(lst.front() == 3 && lst.back() == 5);
+      EXPECT_TRUE(*lst.rbegin() == 5);
+      EXPECT_TRUE(MemoryManager::allocator_allocated == allocated);
+
+      lst.pop_front();
+      lst.push_back(6);
+      lst.push_front(2);
+      EXPECT_TRUE(AreListsEqual(lst, List<int>({2, 4, 5})));
+
+      auto copy = lst;
+      EXPECT_TRUE(AreListsEqual(copy, lst));
+    }
+    EXPECT_TRUE(MemoryManager::allocator_allocated ==
+                MemoryManager::allocator_deallocated);
+    EXPECT_TRUE(MemoryManager::allocator_constructed ==
+                MemoryManager::allocator_destroyed);
+  }
+
+  {
+    Accountant::reset();
+    {
+      BoundedList<Accountant> lst(2);
+      Accountant value;
+      for (int i = 0; i < 10; ++i) {
+        lst.push_back(value);
+      }
+      EXPECT_TRUE(lst.size() == 2);
+    }
+    EXPECT_TRUE(Accountant::ctor_calls == Accountant::dtor_calls);
+  }
+}
+
+constexpr int ConstexprListChecksum() {
+  List<int> lst = {1, 2, 3, 4};
+  lst.push_back(5);
+  lst.push_front(0);
+  lst.pop_back();
+
+  List<int> copy = lst;
+  copy.pop_front();
+
+  int sum = 0;
+  for (auto it = copy.rbegin(); it != copy.rend(); ++it) {
+    sum = sum * 10 + *it;
+  }
+  return sum + static_cast<int>(List<int>(3).size()) * 100000;
+}
+
+constexpr std::array<int, 5> kSquaresTable = [] {
+  List<int> lst;
+  for (int i = 1; i <= 5; ++i) {
+    lst.push_back(i * i);
+  }
+
+  std::array<int, 5> table{};
+  std::copy(lst.begin(), lst.end(), table.begin());
+  return table;
+}();
+
+void CONSTEXPR() {
+  std::cout << "Checking constexpr list: \n";
+
+  static_assert(ConstexprListChecksum() == 304321);
+  static_assert(kSquaresTable[0] == 1 && kSquaresTable[4] == 25);
+  static_assert(List<int>(2, 7).front() == 7);
+
+  EXPECT_TRUE(ConstexprListChecksum() == 304321);
+  EXPECT_TRUE(kSquaresTable[2] == 9);
+}
+
+template <typename L>
+concept HasSize = requires(const L& lst) { lst.size(); };
+
+template <typename L>
+void FifoPolicyTest() {
+  L lst = {1, 2, 3};
+  lst.push_back(4);
+  lst.push_front(0);
+  lst.pop_front();
+
+  std::vector<int> values(lst.begin(), lst.end());
+  EXPECT_TRUE((values == std::vector<int>{1, 2, 3, 4}));
+  EXPECT_TRUE(lst.front() == 1 && lst.back() == 4);
+
+  L copy = lst;
+  copy.pop_front();
+  lst = copy;
+  EXPECT_TRUE(AreListsEqual(std::vector<int>(lst.begin(), lst.end()),
+                            std::vector<int>{2, 3, 4}));
+
+  std::vector<int> popped;
+  lst.pop_front_n(10, std::back_inserter(popped));
+  EXPECT_TRUE(lst.empty() && popped.size() == 3);
+
+  lst.append(std::move(copy));
+  EXPECT_TRUE(copy.empty() && !lst.empty());
+}
+
+// Move assignment steals the nodes when the allocators compare equal and
+// moves the elements into the target's own nodes when they do not.
+template <typename LinkPolicy>
+void MoveAssignPolicyTest() {
+  using L = List<int, std::pmr::polymorphic_allocator<int>, LinkPolicy>;
+  std::pmr::unsynchronized_pool_resource first_pool;
+  std::pmr::unsynchronized_pool_resource second_pool;
+
+  L source({1, 2, 3}, &first_pool);
+  const int* front = &source.front();
+  L same({9}, &first_pool);
+  same = std::move(source);
+  EXPECT_TRUE(&same.front() == front && source.empty());
+
+  L other({9}, &second_pool);
+  other = std::move(same);
+  EXPECT_TRUE(AreListsEqual(std::vector<int>(other.begin(), other.end()),
+                            std::vector<int>{1, 2, 3}));
+  EXPECT_TRUE(same.empty() && &other.front() != front &&
+              other.get_allocator().resource() == &second_pool);
+}
+
+void POLICIES() {
+  std::cout << "Checking list policies: \n";
+
+  using ForwardList = List<int, std::allocator<int>, Links::Single>;
+  using ForwardUntracked =
+      List<int, std::allocator<int>, Links::Single, Size::Untracked>;
+  using DoubleUntracked =
+      List<int, std::allocator<int>, Links::Double, Size::Untracked>;
+
+  EXPECT_TRUE(sizeof(ForwardNode<int>) < sizeof(Node<int>));
+  EXPECT_TRUE(sizeof(ForwardUntracked) < sizeof(ForwardList));
+  EXPECT_TRUE(sizeof(DoubleUntracked) < sizeof(List<int>));
+
+  EXPECT_TRUE(HasSize<List<int>> && HasSize<ForwardList>);
+  EXPECT_FALSE(HasSize<ForwardUntracked> || HasSize<DoubleUntracked>);
+
+  {
+    auto test = std::is_same_v<
+        std::iterator_traits<ForwardList::iterator>::iterator_category,
+        std::forward_iterator_tag>;
+    EXPECT_TRUE(test);
+  }
+
+  FifoPolicyTest<ForwardList>();
+  FifoPolicyTest<ForwardUntracked>();
+  FifoPolicyTest<DoubleUntracked>();
+
+  MoveAssignPolicyTest<Links::Double>();
+  MoveAssignPolicyTest<Links::Single>();
+  MoveAssignPolicyTest<Links::Xor>();
+
+  {
+    using XorList = List<int, std::allocator<int>, Links::Xor>;
+
+    EXPECT_TRUE(sizeof(XorNode<int>) < sizeof(Node<int>));
+
+    XorList lst = {2, 3};
+    lst.push_front(1);
+    lst.push_back(4);
+    lst.push_back(5);
+    lst.pop_back();
+    EXPECT_TRUE(lst.size() == 4);
+    EXPECT_TRUE(lst.front() == 1 && lst.back() == 4);
+
+    std::string forward;
+    for (int x : lst) {
+      forward += std::to_string(x);
+    }
+    std::string backward;
+    for (auto it = lst.rbegin(); it != lst.rend(); ++it) {
+      backward += std::to_string(*it);
+    }
+    EXPECT_TRUE(forward == "1234" && backward == "4321");
+
+    auto it = lst.end();
+    --it;
+    --it;
+    EXPECT_TRUE(*it == 3);
+    ++it;
+    EXPECT_TRUE(*it == 4);
+
+    std::reverse(lst.begin(), lst.end());
+    XorList copy = lst;
+    copy.pop_front();
+    lst = copy;
+    EXPECT_TRUE(AreListsEqual(lst, std::vector<int>{3, 2, 1}));
+
+    lst.clear();
+    EXPECT_TRUE(lst.empty() && lst.begin() == lst.end());
+  }
+
+  {
+    SetupTest();
+    {
+      List<int, AllocatorWithCount<int>, Links::Single> lst(5, 7);
+      EXPECT_TRUE(lst.size() == 5);
+      lst.pop_front();
+      lst.push_back(8);
+      EXPECT_TRUE(lst.back() == 8);
+    }
+    EXPECT_TRUE(MemoryManager::allocator_allocated ==
+                MemoryManager::allocator_deallocated);
+    EXPECT_TRUE(MemoryManager::allocator_allocated ==
+                6 * sizeof(ForwardNode<int>));
+  }
+
+  {
+    Accountant::reset();
+    ThrowingAccountant::need_throw = true;
+    try {
+      List<ThrowingAccountant, std::allocator<ThrowingAccountant>,
+           Links::Single>
+          lst(8);
+    } catch (...) {
+      EXPECT_TRUE(Accountant::ctor_calls == Accountant::dtor_calls);
+    }
+    ThrowingAccountant::need_throw = false;
+  }
+}
+
+void PMR() {
+  std::cout << "Checking pmr list: \n";
+
+  {
+    auto test = std::is_same_v<
+        pmr::List<int>::allocator_type, std::pmr::polymorphic_allocator<int>>;
+    EXPECT_TRUE(test);
+  }
+
+  {
+    CountingResource upstream;
+    std::pmr::monotonic_buffer_resource arena(&upstream);
+    {
+      pmr::List<int> lst({1, 2, 3}, &arena);
+      lst.push_back(4);
+      lst.push_front(0);
+
+      EXPECT_TRUE(lst.get_allocator().resource() == &arena);
+      EXPECT_TRUE(upstream.allocations != 0);
+      EXPECT_TRUE(AreListsEqual(lst, List<int>({0, 1, 2, 3, 4})));
+
+      // Copies fall back to the default resource, assignment keeps the
+      // destination's resource since pmr allocators never propagate.
+      pmr::List<int> copy = lst;
+      EXPECT_TRUE(copy.get_allocator().resource() ==
+                  std::pmr::get_default_resource());
+
+      pmr::List<int> target(&arena);
+      target = copy;
+      EXPECT_TRUE(target.get_allocator().resource() == &arena);
+      EXPECT_TRUE(AreListsEqual(target, lst));
+
+      pmr::List<int> extended(lst, &arena);
+      EXPECT_TRUE(extended.get_allocator().resource() == &arena);
+      EXPECT_TRUE(AreListsEqual(extended, lst));
+
+      pmr::List<int> moved = std::move(extended);
+      EXPECT_TRUE(moved.get_allocator().resource() == &arena);
+      EXPECT_TRUE(extended.empty() && AreListsEqual(moved, lst));
+
+      copy = std::move(moved);
+      EXPECT_TRUE(copy.get_allocator().resource() ==
+                  std::pmr::get_default_resource());
+      EXPECT_TRUE(moved.empty() && AreListsEqual(copy, lst));
+    }
+    EXPECT_TRUE(upstream.deallocated == 0);
+  }
+
+  {
+    CountingResource upstream;
+    {
+      std::pmr::unsynchronized_pool_resource pool(&upstream);
+      pmr::List<TypeWithCounts> lst(&pool);
+      for (int i = 0; i < 1000; ++i) {
+        lst.push_back(i);
+      }
+      for (int i = 0; i < 500; ++i) {
+        lst.pop_front();
+      }
+      for (int i = 0; i < 500; ++i) {
+        lst.push_back(i);
+      }
+
+      EXPECT_TRUE(lst.size() == 1000);
+      EXPECT_TRUE(upstream.allocations < 100);
+
+      pmr::List<TypeWithCounts> other(&pool);
+      other.push_back(1);
+      other.append(std::move(lst));
+      EXPECT_TRUE(other.size() == 1001 && lst.empty());
+    }
+    EXPECT_TRUE(upstream.allocated == upstream.deallocated);
+  }
+}
+
+void NOEXCEPT_PUSH() {
+  std::cout << "Checking conditional noexcept: \n";
+
+  List<int, NoexceptAllocator<int>> nothrow_list;
+  List<int> std_list;
+  List<ThrowingAccountant, NoexceptAllocator<ThrowingAccountant>>
+      throwing_list;
+
+  EXPECT_TRUE(noexcept(nothrow_list.push_back(1)));
+  EXPECT_TRUE(noexcept(nothrow_list.emplace_front(1)));
+  EXPECT_FALSE(noexcept(std_list.push_back(1)));
+  EXPECT_FALSE(noexcept(throwing_list.push_back(ThrowingAccountant())));
+  EXPECT_TRUE(std::is_nothrow_move_constructible_v<List<int>>);
+
+  nothrow_list.emplace_back(2);
+  nothrow_list.emplace_front(1);
+  EXPECT_TRUE(AreListsEqual(nothrow_list, List<int>({1, 2})));
+}
+
+// Random sequences of operations on lists of ThrowingAccountant, which
+// throws on every fifth construction. Every failed operation must leave the
+// list as it was, and in the end every allocation done through
+// AllocatorWithCount has to be freed and every Accountant destroyed
+// (AllocatorWithCount counts construction attempts, not successes).
+void FUZZ_EXCEPTIONS() {
+  std::cout << "Fuzzing exception safety: \n";
+
+  using FuzzList = List<ThrowingAccountant,
+                        AllocatorWithCount<ThrowingAccountant>>;
+
+  SetupTest();
+  Accountant::reset();
+  ThrowingAccountant::need_throw = true;
+
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> op_dist(0, 8);
+  std::uniform_int_distribution<int> size_dist(0, 12);
+
+  bool consistent = true;
+  size_t throws = 0;
+
+  for (int round = 0; round < 200; ++round) {
+    FuzzList lst;
+    std::vector<int> model;
+
+    auto matches = [&lst, &model] {
+      if (lst.size() != model.size()) {
+        return false;
+      }
+      size_t i = 0;
+      for (auto& val : lst) {
+        if (val.value != model[i++]) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    for (int step = 0; step < 30; ++step) {
+      int size = size_dist(gen);
+      try {
+        switch (op_dist(gen)) {
+          case 0:
+            lst.push_back(ThrowingAccountant(step));
+            model.push_back(step);
+            break;
+          case 1:
+            lst.push_front(ThrowingAccountant(step));
+            model.insert(model.begin(), step);
+            break;
+          case 2: {
+            FuzzList other(static_cast<size_t>(size), ThrowingAccountant(step));
+            lst = other;
+            model.assign(size, step);
+            break;
+          }
+          case 3: {
+            FuzzList copy(lst);
+            lst = copy;
+            break;
+          }
+          case 4: {
+            std::vector<ThrowingAccountant> values(size);
+            lst.push_back_n(values.begin(), values.end());
+            model.insert(model.end(), size, 0);
+            break;
+          }
+          case 5: {
+            FuzzList other(static_cast<size_t>(size));
+            lst.append(std::move(other));
+            model.insert(model.end(), size, 0);
+            break;
+          }
+          case 6:
+            if (!lst.empty()) {
+              lst.pop_front();
+              model.erase(model.begin());
+            }
+            break;
+          case 7:
+            lst.compact();
+            break;
+          default:
+            lst.emplace_back(step);
+            model.push_back(step);
+            break;
+        }
+      } catch (const std::string&) {
+        ++throws;
+      }
+
+      consistent = consistent && matches();
+    }
+  }
+
+  ThrowingAccountant::need_throw = false;
+
+  EXPECT_TRUE(consistent);
+  EXPECT_TRUE(throws != 0);
+  EXPECT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+  EXPECT_TRUE(Accountant::ctor_calls == Accountant::dtor_calls);
+}
+
+void RANGES() {
+  std::cout << "Checking ranges: \n";
+
+  using ForwardList = List<int, std::allocator<int>, Links::Single>;
+  using XorList = List<int, std::allocator<int>, Links::Xor>;
+
+  static_assert(std::bidirectional_iterator<List<int>::iterator>);
+  static_assert(std::bidirectional_iterator<List<int>::const_iterator>);
+  static_assert(std::bidirectional_iterator<List<int>::reverse_iterator>);
+  static_assert(std::ranges::bidirectional_range<List<int>>);
+  static_assert(std::ranges::bidirectional_range<const List<int>>);
+  static_assert(std::ranges::common_range<List<int>>);
+  static_assert(std::ranges::sized_range<List<int>>);
+  static_assert(std::ranges::viewable_range<List<int>&>);
+  static_assert(std::forward_iterator<ForwardList::iterator>);
+  static_assert(std::ranges::forward_range<ForwardList>);
+  static_assert(std::ranges::bidirectional_range<XorList>);
+  static_assert(std::is_convertible_v<List<int>::iterator,
+                                      List<int>::const_iterator>);
+  static_assert(!std::is_convertible_v<List<int>::const_iterator,
+                                       List<int>::iterator>);
+
+  List<int> lst = {1, 2, 3, 4, 5, 6, 7, 8};
+
+  auto pipeline = lst | std::views::filter([](int x) { return x % 2 == 0; }) |
+                  std::views::transform([](int x) { return x * 10; }) |
+                  std::views::reverse;
+
+  std::vector<int> values(pipeline.begin(), pipeline.end());
+  EXPECT_TRUE((values == std::vector<int>{80, 60, 40, 20}));
+
+  auto taken = lst | std::views::take(3);
+  EXPECT_TRUE(std::ranges::distance(taken) == 3);
+
+  for (int& x : lst | std::views::drop(6)) {
+    x = 0;
+  }
+  EXPECT_TRUE(lst.back() == 0);
+
+  XorList xor_list = {1, 2, 3};
+  auto reversed = xor_list | std::views::reverse;
+  EXPECT_TRUE(*reversed.begin() == 3);
+
+  List<int>::const_iterator it = lst.begin();
+  EXPECT_TRUE(it == lst.cbegin());
+}
+
+void CURSOR() {
+  std::cout << "Checking cursors: \n";
+
+  {
+    List<int> lst = {1, 2, 3, 4, 5, 6};
+    List<int>::Cursor cursor(lst);
+
+    EXPECT_TRUE(cursor.advance(2) == 2 && *cursor == 3);
+
+    // Erasing the current element moves the cursor on.
+    lst.erase(cursor.position());
+    EXPECT_TRUE(*cursor == 4);
+
+    // Changes elsewhere do not disturb it.
+    lst.pop_front();
+    lst.push_front(0);
+    lst.insert(cursor.position(), 10);
+    lst.pop_back();
+    EXPECT_TRUE(*cursor == 4);
+
+    std::vector<int> seen;
+    size_t visited =
+        cursor.for_each_chunk(10, [&seen](int x) { seen.push_back(x); });
+    EXPECT_TRUE(visited == 2 && (seen == std::vector<int>{4, 5}));
+    EXPECT_TRUE(cursor.at_end());
+
+    cursor.reset();
+    EXPECT_TRUE(*cursor == 0);
+
+    List<int>::Cursor other(lst, std::next(lst.begin()));
+    std::vector<int> popped;
+    lst.pop_front_n(3, std::back_inserter(popped));
+    EXPECT_TRUE(*cursor == 4 && *other == 4);
+
+    lst.clear();
+    EXPECT_TRUE(cursor.at_end() && cursor.attached());
+  }
+
+  {
+    List<int> lst;
+    for (int i = 0; i < 100; ++i) {
+      lst.push_back(i);
+    }
+
+    // Walk the list in chunks of 7 while the callback erases every odd
+    // element it meets and appends new ones at the back.
+    List<int>::Cursor cursor(lst);
+    int ticks = 0;
+    int sum = 0;
+    while (cursor.for_each_chunk(7, [&lst, &sum, &cursor](int& x) {
+      sum += x;
+      if (x % 2 == 1) {
+        lst.erase(std::prev(cursor.position()));
+      } else if (x < 10) {
+        lst.push_back(1000 + x);
+      }
+    }) == 7) {
+      ++ticks;
+      lst.pop_front();
+    }
+
+    EXPECT_TRUE(ticks == 15);
+    EXPECT_TRUE(sum == 4950 + 1000 * 5 + 20);
+    EXPECT_TRUE(std::all_of(lst.begin(), lst.end(),
+                            [](int x) { return x % 2 == 0; }));
+  }
+
+  {
+    auto cursor = [] {
+      List<int> lst = {1, 2};
+      return List<int>::Cursor(lst);
+    }();
+    EXPECT_FALSE(cursor.attached());
+    EXPECT_TRUE(cursor.at_end());
+  }
+}
+
+void LRU_CACHE() {
+  std::cout << "Checking lru cache: \n";
+  {
+    SetupTest();
+    {
+      LruCache<int, std::string, std::hash<int>, std::equal_to<int>,
+               AllocatorWithCount<std::pair<const int, std::string>>>
+          cache(3);
+      size_t allocated = MemoryManager::allocator_allocated;
+
+      cache.put(1, "one");
+      cache.put(2, "two");
+      cache.put(3, "three");
+      EXPECT_TRUE(cache.size() == 3);
+      EXPECT_TRUE(*cache.get(1) == "one");
+
+      cache.put(4, "four");
+      EXPECT_FALSE(cache.contains(2));
+      EXPECT_TRUE(cache.contains(1) && cache.contains(3) && cache.contains(4));
+      EXPECT_TRUE(cache.size() == 3);
+
+      std::vector<int> order;
+      cache.for_each([&order](int key, std::string&) { order.push_back(key); });
+      EXPECT_TRUE((order == std::vector<int>{4, 1, 3}));
+
+      EXPECT_TRUE(*cache.peek(3) == "three");
+      cache.put(5, "five");
+      EXPECT_FALSE(cache.contains(3));
+
+      cache.put(1, "uno");
+      EXPECT_TRUE(*cache.get(1) == "uno");
+      EXPECT_TRUE(cache.erase(4));
+      EXPECT_FALSE(cache.erase(4));
+      EXPECT_TRUE(cache.size() == 2 && cache.get(4) == nullptr);
+      EXPECT_TRUE(MemoryManager::allocator_allocated == allocated);
+    }
+    EXPECT_TRUE(MemoryManager::allocator_allocated ==
+                MemoryManager::allocator_deallocated);
+  }
+
+  {
+    // Random operations against a reference model built on List.
+    constexpr size_t kCapacity = 64;
+    LruCache<int, int> cache(kCapacity);
+    List<std::pair<int, int>> model;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> key(0, 255);
+    std::uniform_int_distribution<int> kind(0, 9);
+    bool same = true;
+
+    auto find = [&model](int k) {
+      return std::find_if(model.begin(), model.end(),
+                          [k](const auto& entry) { return entry.first == k; });
+    };
+
+    for (int i = 0; i < 20000; ++i) {
+      int k = key(gen);
+      int op = kind(gen);
+      auto it = find(k);
+
+      if (op < 4) {
+        int* got = cache.get(k);
+        same = same && ((got == nullptr) == (it == model.end()));
+        if (it != model.end()) {
+          same = same && *got == it->second;
+          auto entry = *it;
+          model.erase(it);
+          model.push_front(entry);
+        }
+      } else if (op < 9) {
+        cache.put(k, i);
+        if (it != model.end()) {
+          model.erase(it);
+        } else if (model.size() == kCapacity) {
+          model.pop_back();
+        }
+        model.push_front({k, i});
+      } else {
+        same = same && cache.erase(k) == (it != model.end());
+        if (it != model.end()) {
+          model.erase(it);
+        }
+      }
+    }
+
+    std::vector<std::pair<int, int>> entries;
+    cache.for_each([&entries](int k, int v) { entries.emplace_back(k, v); });
+    EXPECT_TRUE(same);
+    EXPECT_TRUE(cache.size() == model.size());
+    EXPECT_TRUE(std::equal(entries.begin(), entries.end(), model.begin(),
+                           model.end()));
+  }
+
+  {
+    Accountant::reset();
+    {
+      LruCache<int, Accountant> cache(2);
+      Accountant value;
+      for (int i = 0; i < 10; ++i) {
+        cache.put(i, value);
+      }
+      cache.erase(9);
+      EXPECT_TRUE(cache.size() == 1);
+    }
+    EXPECT_TRUE(Accountant::ctor_calls == Accountant::dtor_calls);
+  }
+}
+
+void SHARDED() {
+  std::cout << "Checking sharded list: \n";
+  {
+    constexpr int kThreads = 6;
+    constexpr int kPerThread = 5000;
+    ShardedList<std::pair<int, int>> lst(4);
+    EXPECT_TRUE(lst.shard_count() == 4);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&lst, t] {
+        for (int i = 0; i < kPerThread; ++i) {
+          lst.push_back({t, i});
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_TRUE(lst.size() == kThreads * kPerThread);
+
+    List<std::pair<int, int>> out;
+    out.push_back({-1, 0});
+    lst.drain_into(out);
+    EXPECT_TRUE(lst.empty());
+    EXPECT_TRUE(out.size() == kThreads * kPerThread + 1);
+    EXPECT_TRUE(out.front().first == -1);
+
+    // Each thread's elements keep their relative order.
+    std::vector<int> next(kThreads, 0);
+    bool ordered = true;
+    for (auto it = std::next(out.begin()); it != out.end(); ++it) {
+      ordered = ordered && it->second == next[it->first]++;
+    }
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(std::all_of(next.begin(), next.end(),
+                            [](int n) { return n == kPerThread; }));
+  }
+
+  {
+    CountingResource resource;
+    {
+      ShardedList<int, std::pmr::polymorphic_allocator<int>> lst(2, &resource);
+      for (int i = 0; i < 10; ++i) {
+        lst.emplace_back(i);
+      }
+      int sum = 0;
+      lst.for_each([&sum](int x) { sum += x; });
+      EXPECT_TRUE(sum == 45);
+
+      size_t allocations = resource.allocations;
+      pmr::List<int> out(&resource);
+      lst.drain_into(out);
+      EXPECT_TRUE(resource.allocations == allocations);
+      EXPECT_TRUE(out.size() == 10 && lst.size() == 0);
+
+      lst.push_back(1);
+      lst.clear();
+      EXPECT_TRUE(lst.empty());
+    }
+    EXPECT_TRUE(resource.allocated == resource.deallocated);
+  }
+
+  {
+    SetupTest();
+    {
+      ShardedList<int, AllocatorWithCount<int>> lst(3);
+      for (int i = 0; i < 10; ++i) {
+        lst.push_back(i);
+      }
+      List<int, AllocatorWithCount<int>> out;
+      lst.drain_into(out);
+      EXPECT_TRUE(out.size() == 10 && lst.empty());
+    }
+    EXPECT_TRUE(MemoryManager::allocator_allocated ==
+                MemoryManager::allocator_deallocated);
+  }
+}
+
+void HUGE_PAGES() {
+  std::cout << "Checking huge page allocator: \n";
+  {
+    HugePageAllocator<int> alloc(HugePageOptions{true, true});
+    {
+      List<int, HugePageAllocator<int>> lst(alloc);
+      for (int i = 0; i < 100000; ++i) {
+        lst.push_back(i);
+      }
+      for (int i = 0; i < 50000; ++i) {
+        lst.pop_front();
+      }
+      List<int, HugePageAllocator<int>> other(alloc);
+      other.push_back(-1);
+      other.append(std::move(lst));
+
+      EXPECT_TRUE(other.size() == 50001);
+      EXPECT_TRUE(other.front() == -1 && other.back() == 99999);
+      EXPECT_TRUE(std::accumulate(other.begin(), other.end(), 0LL) ==
+                  3749975000LL - 1);
+    }
+
+    HugePageArena& arena = alloc.arena();
+    size_t slabs = arena.slab_count(HugePageArena::Backing::Hugetlb) +
+                   arena.slab_count(HugePageArena::Backing::Transparent) +
+                   arena.slab_count(HugePageArena::Backing::Regular);
+    EXPECT_TRUE(slabs >= 1);
+    // Every Linux machine has node 0, so binding has to work here too.
+    EXPECT_TRUE(arena.bound_slab_count() == slabs);
+  }
+
+  {
+    HugePageAllocator<int64_t> alloc(HugePageOptions{false, false});
+    HugePageAllocator<Node<int64_t>> rebound(alloc);
+    EXPECT_TRUE(alloc == rebound);
+    EXPECT_FALSE(alloc == HugePageAllocator<int64_t>());
+
+    Node<int64_t>* first = rebound.allocate(1);
+    rebound.deallocate(first, 1);
+    EXPECT_TRUE(rebound.allocate(1) == first);
+
+    int64_t* big = alloc.allocate(1000);
+    big[999] = 1;
+    alloc.deallocate(big, 1000);
+    EXPECT_TRUE(alloc.arena().slab_count(HugePageArena::Backing::Regular) == 1);
+  }
+}
+
+void COMPACT() {
+  std::cout << "Checking compaction: \n";
+  {
+    // A monotonic resource never reuses memory, so fresh nodes come out in
+    // allocation order.
+    std::pmr::monotonic_buffer_resource arena;
+    pmr::List<int> lst(&arena);
+    for (int i = 0; i < 1000; ++i) {
+      if (i % 2 == 0) {
+        lst.push_back(i);
+      } else {
+        lst.push_front(i);
+      }
+    }
+    std::vector<int> before(lst.begin(), lst.end());
+
+    pmr::List<int>::Cursor cursor(lst, std::next(lst.begin(), 10));
+    lst.compact();
+
+    auto ascending = [&lst] {
+      const int* prev = nullptr;
+      for (const int& x : lst) {
+        if (prev != nullptr && &x < prev) {
+          return false;
+        }
+        prev = &x;
+      }
+      return true;
+    };
+    EXPECT_TRUE(ascending());
+    EXPECT_TRUE(std::ranges::equal(lst, before));
+    EXPECT_TRUE(*cursor == before[10]);
+    EXPECT_TRUE(lst.size() == 1000);
+  }
+
+  {
+    SetupTest();
+    {
+      List<std::string, AllocatorWithCount<std::string>> lst;
+      for (int i = 0; i < 100; ++i) {
+        lst.push_back(std::to_string(i));
+      }
+
+      using Cursor = List<std::string, AllocatorWithCount<std::string>>::Cursor;
+      Cursor pass(lst);
+      Cursor watcher(lst, std::next(lst.begin(), 42));
+      size_t ticks = 0;
+      while (lst.compact(pass, 16) == 16) {
+        ++ticks;
+        lst.pop_back();
+      }
+
+      EXPECT_TRUE(ticks == 5);
+      EXPECT_TRUE(pass.at_end());
+      EXPECT_TRUE(*watcher == "42");
+      EXPECT_TRUE(lst.size() == 95 && lst.back() == "94");
+
+      int expected = 0;
+      bool same = true;
+      for (const auto& str : lst) {
+        same = same && str == std::to_string(expected++);
+      }
+      EXPECT_TRUE(same);
+    }
+    EXPECT_TRUE(MemoryManager::allocator_allocated ==
+                MemoryManager::allocator_deallocated);
+  }
+
+  {
+    // The old nodes of an unfinished pass go back with the list.
+    SetupTest();
+    {
+      using CountedList = List<int, AllocatorWithCount<int>>;
+      std::optional<CountedList> lst(std::in_place, 10, 7);
+      CountedList::Cursor cursor(*lst);
+      EXPECT_TRUE(lst->compact(cursor, 4) == 4);
+      EXPECT_TRUE(*cursor == 7 && lst->size() == 10);
+      lst.reset();
+      EXPECT_FALSE(cursor.attached());
+    }
+    EXPECT_TRUE(MemoryManager::allocator_allocated ==
+                MemoryManager::allocator_deallocated);
+  }
+}
+
+void RCU() {
+  std::cout << "Checking rcu list: \n";
+  {
+    SetupTest();
+    {
+      RcuList<int, AllocatorWithCount<int>> lst;
+      RcuList<int, AllocatorWithCount<int>>::Reader reader(lst);
+      for (int i = 0; i < 10; ++i) {
+        lst.push_back(i);
+      }
+      lst.push_front(-1);
+      lst.pop_back();
+      EXPECT_TRUE(lst.erase_if([](int x) { return x % 2 == 1; }) == 4);
+      EXPECT_TRUE(lst.size() == 6);
+
+      std::vector<int> seen;
+      reader.for_each([&seen](int x) { seen.push_back(x); });
+      EXPECT_TRUE((seen == std::vector<int>{-1, 0, 2, 4, 6, 8}));
+      EXPECT_TRUE(reader.contains(4) && !reader.contains(3));
+
+      {
+        auto section = reader.section();
+        EXPECT_TRUE(std::accumulate(section.begin(), section.end(), 0) == 19);
+        auto it = std::find(section.begin(), section.end(), 6);
+        EXPECT_TRUE(it != section.end() && *std::next(it) == 8);
+
+        // Nodes unlinked inside a section stay readable until it ends.
+        auto last = std::next(it);
+        lst.pop_back();
+        lst.reclaim();
+        EXPECT_TRUE(lst.retired_count() == 6 && *last == 8);
+        EXPECT_TRUE(std::next(it) == section.end());
+
+        std::vector<int> nested;
+        reader.for_each([&nested](int x) { nested.push_back(x); });
+        EXPECT_TRUE((nested == std::vector<int>{-1, 0, 2, 4, 6}));
+      }
+      lst.push_back(8);
+
+      EXPECT_TRUE(lst.retired_count() == 6);
+      lst.synchronize();
+      EXPECT_TRUE(lst.retired_count() == 0);
+      lst.pop_front();
+    }
+    EXPECT_TRUE(MemoryManager::allocator_allocated ==
+                MemoryManager::allocator_deallocated);
+  }
+
+  {
+    // The writer keeps a sliding window of increasing values while readers
+    // check that every traversal sees a strictly increasing sequence.
+    RcuList<int> lst;
+    for (int i = 0; i < 64; ++i) {
+      lst.push_back(i);
+    }
+
+    std::atomic<bool> done = false;
+    std::atomic<bool> ordered = true;
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+      readers.emplace_back([&] {
+        RcuList<int>::Reader reader(lst);
+        while (!done.load()) {
+          int prev = -1;
+          bool ok = true;
+          reader.for_each([&](int x) {
+            ok = ok && x > prev;
+            prev = x;
+          });
+          {
+            auto section = reader.section();
+            ok = ok && std::is_sorted(section.begin(), section.end(),
+                                      std::less_equal<int>());
+          }
+          if (!ok) {
+            ordered = false;
+          }
+        }
+      });
+    }
+
+    for (int i = 64; i < 200000; ++i) {
+      lst.push_back(i);
+      lst.pop_front();
+    }
+    done = true;
+    for (auto& reader : readers) {
+      reader.join();
+    }
+
+    EXPECT_TRUE(ordered.load());
+    EXPECT_TRUE(lst.size() == 64);
+  }
+}
+
+DetachedTask ChannelProducer(AsyncChannel<int>& channel, int from, int to,
+                             std::vector<int>& log) {
+  for (int i = from; i < to; ++i) {
+    bool accepted = co_await channel.push(i);
+    log.push_back(accepted ? i : -i);
+  }
+}
+
+DetachedTask ChannelConsumer(AsyncChannel<int>& channel,
+                             std::vector<int>& out) {
+  while (std::optional<int> val = co_await channel.pop()) {
+    out.push_back(*val);
+  }
+  out.push_back(-1);
+}
+
+DetachedTask ChannelEcho(AsyncChannel<int>& in, AsyncChannel<int>& out) {
+  while (std::optional<int> val = co_await in.pop()) {
+    co_await out.push(*val + 1);
+  }
+}
+
+DetachedTask ChannelPinger(AsyncChannel<int>& out, AsyncChannel<int>& in,
+                           int rounds, int& last) {
+  for (int i = 0; i < rounds; ++i) {
+    co_await out.push(i * 10);
+    last = *co_await in.pop();
+  }
+  out.close();
+}
+
+void ASYNC_CHANNEL() {
+  std::cout << "Checking async channel: \n";
+  {
+    AsyncChannel<int> channel;
+    std::vector<int> out;
+    ChannelConsumer(channel, out);
+    EXPECT_TRUE(out.empty());
+
+    channel.try_push(1);
+    EXPECT_TRUE((out == std::vector<int>{1}));
+    EXPECT_TRUE(channel.size() == 0);
+
+    std::vector<int> log;
+    ChannelProducer(channel, 2, 5, log);
+    EXPECT_TRUE((out == std::vector<int>{1, 2, 3, 4}));
+
+    channel.close();
+    EXPECT_TRUE(out.back() == -1);
+    EXPECT_FALSE(channel.try_push(7));
+  }
+
+  {
+    // Capacity 2: the producer runs ahead by two values, then waits.
+    AsyncChannel<int> channel(2);
+    std::vector<int> log;
+    ChannelProducer(channel, 0, 5, log);
+    EXPECT_TRUE((log == std::vector<int>{0, 1}));
+    EXPECT_TRUE(channel.size() == 2);
+
+    EXPECT_TRUE(*channel.try_pop() == 0);
+    EXPECT_TRUE((log == std::vector<int>{0, 1, 2}));
+    EXPECT_TRUE(channel.size() == 2);
+
+    std::vector<int> out;
+    ChannelConsumer(channel, out);
+    EXPECT_TRUE((out == std::vector<int>{1, 2, 3, 4}));
+    EXPECT_TRUE(log.size() == 5);
+
+    channel.close();
+    EXPECT_TRUE(out.back() == -1);
+  }
+
+  {
+    // Rendezvous channel, closed under a blocked producer.
+    AsyncChannel<int> channel(0);
+    std::vector<int> log;
+    ChannelProducer(channel, 1, 3, log);
+    EXPECT_TRUE(log.empty());
+    EXPECT_TRUE(*channel.try_pop() == 1);
+    EXPECT_TRUE((log == std::vector<int>{1}));
+    channel.close();
+    EXPECT_TRUE((log == std::vector<int>{1, -2}));
+    EXPECT_FALSE(channel.try_pop().has_value());
+  }
+
+  {
+    AsyncChannel<int> ping;
+    AsyncChannel<int> pong;
+    int last = 0;
+    ChannelEcho(ping, pong);
+    ChannelPinger(ping, pong, 1000, last);
+    EXPECT_TRUE(last == 9991);
+    EXPECT_TRUE(ping.closed() && ping.size() == 0 && pong.size() == 0);
+  }
+}
+
+struct TestTimer : Timer {
+  int id = 0;
+};
+
+void TIMER_WHEEL() {
+  std::cout << "Checking timer wheel: \n";
+  {
+    TimerWheel wheel(100);
+    TestTimer a;
+    TestTimer b;
+    TestTimer c;
+    a.id = 1;
+    b.id = 2;
+    c.id = 3;
+
+    wheel.schedule(a, 105);
+    wheel.schedule(b, 100 + 70000);
+    wheel.schedule(c, 50);
+    EXPECT_TRUE(wheel.size() == 3 && a.scheduled());
+
+    std::vector<std::pair<uint64_t, int>> fired;
+    auto record = [&fired, &wheel](Timer& timer) {
+      fired.emplace_back(wheel.now(), static_cast<TestTimer&>(timer).id);
+    };
+
+    wheel.advance(104, record);
+    EXPECT_TRUE((fired == std::vector<std::pair<uint64_t, int>>{{101, 3}}));
+    EXPECT_TRUE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(a));
+
+    wheel.advance(100 + 69999, record);
+    EXPECT_TRUE(fired.size() == 1);
+    wheel.advance(200000, record);
+    EXPECT_TRUE(fired.back() == std::make_pair(uint64_t(70100), 2));
+    EXPECT_TRUE(wheel.empty() && !b.scheduled());
+
+    {
+      TestTimer scoped;
+      wheel.schedule(scoped, 300000);
+      EXPECT_TRUE(wheel.size() == 1);
+    }
+    EXPECT_TRUE(wheel.empty());
+  }
+
+  {
+    // Random schedule/cancel/advance with timeouts spanning every level
+    // and beyond. Every timer has to fire exactly at its expiry, or on the
+    // next tick when it was scheduled for the current one.
+    TimerWheel wheel;
+    std::vector<TestTimer> timers(500);
+    std::vector<uint64_t> due(timers.size());
+    std::multimap<uint64_t, int> model;
+    for (size_t i = 0; i < timers.size(); ++i) {
+      timers[i].id = static_cast<int>(i);
+    }
+
+    std::mt19937_64 gen(11);
+    std::uniform_int_distribution<size_t> pick(0, timers.size() - 1);
+    std::uniform_int_distribution<int> shift(0, 36);
+    bool same = true;
+    size_t fired = 0;
+
+    auto schedule = [&wheel, &due](TestTimer& timer, uint64_t expiry) {
+      due[timer.id] = std::max(expiry, wheel.now() + 1);
+      wheel.schedule(timer, expiry);
+    };
+    auto record = [&](Timer& timer) {
+      auto& test_timer = static_cast<TestTimer&>(timer);
+      same = same && due[test_timer.id] == wheel.now();
+      ++fired;
+      // Every tenth expiry reschedules itself from the callback.
+      if (test_timer.id % 10 == 0) {
+        schedule(test_timer, wheel.now() + test_timer.id % 3);
+      }
+    };
+
+    for (int step = 0; step < 20000; ++step) {
+      size_t i = pick(gen);
+      if (gen() % 4 != 0) {
+        schedule(timers[i],
+                 wheel.now() + (gen() & ((uint64_t(1) << shift(gen)) - 1)));
+      } else {
+        wheel.cancel(timers[i]);
+      }
+
+      if (step % 7 == 0) {
+        wheel.advance(wheel.now() + (gen() % 300), record);
+      }
+
+      model.clear();
+      for (auto& timer : timers) {
+        if (timer.scheduled()) {
+          model.emplace(due[timer.id], timer.id);
+        }
+      }
+      same = same && model.size() == wheel.size();
+      same = same && (model.empty() || model.begin()->first > wheel.now());
+    }
+    EXPECT_TRUE(same);
+    EXPECT_TRUE(fired > 1000);
+
+    // Far timers still come due exactly on time.
+    TestTimer far;
+    uint64_t far_due = wheel.now() + (uint64_t(1) << 33) + 12345;
+    wheel.schedule(far, far_due);
+    uint64_t fired_at = 0;
+    for (auto& timer : timers) {
+      wheel.cancel(timer);
+    }
+    wheel.advance(far_due + 10, [&fired_at, &wheel](Timer&) {
+      fired_at = wheel.now();
+    });
+    EXPECT_TRUE(fired_at == far_due);
+  }
+}
+
+struct CopyBomb {
+  static std::atomic<int> live;
+  static constexpr int kFuse = 30000;
+
+  int value;
+
+  CopyBomb(int value) : value(value) { ++live; }
+
+  CopyBomb(const CopyBomb& other) : value(other.value) {
+    if (value == kFuse) {
+      throw std::string("boom");
+    }
+    ++live;
+  }
+
+  ~CopyBomb() { --live; }
+};
+
+std::atomic<int> CopyBomb::live = 0;
+
+void PARALLEL_COPY() {
+  std::cout << "Checking parallel copy: \n";
+  ThreadExecutor executor(4);
+  {
+    List<int> source;
+    for (int i = 0; i < 100000; ++i) {
+      source.push_back(i);
+    }
+    List<int> copy = List<int>::parallel_copy(source, executor);
+    EXPECT_TRUE(copy.size() == source.size());
+    EXPECT_TRUE(std::ranges::equal(copy, source));
+
+    copy.push_back(-1);
+    EXPECT_TRUE(copy.back() == -1 && *std::prev(copy.end(), 2) == 99999);
+
+    List<int> small = {1, 2, 3};
+    EXPECT_TRUE(std::ranges::equal(List<int>::parallel_copy(small, executor),
+                                   small));
+  }
+
+  {
+    using Untracked =
+        List<std::string, std::allocator<std::string>, Links::Double,
+             Size::Untracked>;
+    Untracked source;
+    for (int i = 0; i < 20000; ++i) {
+      source.push_back(std::to_string(i));
+    }
+    Untracked copy = Untracked::parallel_copy(source, executor);
+    EXPECT_TRUE(std::ranges::equal(copy, source));
+  }
+
+  {
+    List<CopyBomb> source;
+    for (int i = 0; i < 50000; ++i) {
+      source.emplace_back(i);
+    }
+    int live = CopyBomb::live;
+    bool thrown = false;
+    try {
+      List<CopyBomb>::parallel_copy(source, executor);
+    } catch (const std::string&) {
+      thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+    EXPECT_TRUE(CopyBomb::live == live);
+  }
+}
+
+void TRACE() {
+  std::cout << "Checking operation trace: \n";
+  using Op = ListTrace::Op;
+  {
+    ListTrace trace;
+    TracingList<int> lst(&trace);
+    lst.push_back(1);
+    lst.push_front(0);
+    lst.emplace_back(2);
+    std::vector<int> batch(100, 7);
+    lst.push_back_n(batch.begin(), batch.end());
+    int sum = 0;
+    lst.for_each([&sum](int x) { sum += x; });
+    lst.find_if([](int x) { return x == 2; });
+    std::vector<int> out;
+    lst.pop_front_n(50, std::back_inserter(out));
+    lst.pop_back();
+    lst.pop_front();
+    lst.clear();
+
+    std::vector<ListTrace::Record> expected = {
+        {Op::PushBack, 0},   {Op::PushFront, 0}, {Op::PushBack, 0},
+        {Op::PushBackN, 100}, {Op::Iterate, 103}, {Op::Iterate, 3},
+        {Op::PopFrontN, 50}, {Op::PopBack, 0},   {Op::PopFront, 0},
+        {Op::Clear, 0}};
+    EXPECT_TRUE(trace.records() == expected);
+    EXPECT_TRUE(trace.element_size() == sizeof(int));
+    // Seven one-byte records, three escaped arguments of one byte each.
+    EXPECT_TRUE(trace.byte_size() == 13);
+
+    std::stringstream file;
+    trace.save(file);
+    ListTrace loaded = ListTrace::load(file);
+    EXPECT_TRUE(loaded.records() == expected);
+    EXPECT_TRUE(loaded.element_size() == sizeof(int));
+  }
+
+  {
+    ListTrace trace;
+    TracingList<int> lst(&trace);
+    for (int i = 0; i < 1000; ++i) {
+      lst.push_back(i);
+      if (i % 3 == 0) {
+        lst.pop_front();
+      }
+    }
+    lst.for_each([](int) {});
+
+    List<int> replayed;
+    size_t visited = 0;
+    EXPECT_TRUE(replay_trace(trace, replayed, [&visited](int) { visited++; }) ==
+                0);
+    EXPECT_TRUE(replayed.size() == lst.size());
+    EXPECT_TRUE(visited == lst.size());
+
+    using XorList = List<int, std::allocator<int>, Links::Xor>;
+    XorList xor_replayed;
+    replay_trace(trace, xor_replayed, [](int) {});
+    EXPECT_TRUE(std::distance(xor_replayed.begin(), xor_replayed.end()) ==
+                static_cast<std::ptrdiff_t>(lst.size()));
+  }
+
+  {
+    // Attached after two pushes, so the trace pops more than it pushes.
+    ListTrace trace;
+    TracingList<int> lst(nullptr);
+    lst.push_back(1);
+    lst.push_back(2);
+    lst.set_trace(&trace);
+    lst.push_back(3);
+    lst.pop_front();
+    lst.pop_back();
+    lst.pop_front();
+
+    List<int> replayed;
+    EXPECT_TRUE(replay_trace(trace, replayed, [](int) {}) == 2);
+    EXPECT_TRUE(replayed.empty());
+
+    ListTrace made_up;
+    made_up.record(ListTrace::Op::PushBackN, 3);
+    made_up.record(ListTrace::Op::PopFrontN, 5);
+    made_up.record(ListTrace::Op::PushBack);
+    made_up.record(ListTrace::Op::PopBack);
+    made_up.record(ListTrace::Op::PopBack);
+    EXPECT_TRUE(replay_trace(made_up, replayed, [](int) {}) == 3);
+    EXPECT_TRUE(replayed.empty());
+  }
+
+  {
+    // No size() to read: batches are counted as they go by.
+    ListTrace trace;
+    TracingList<int, std::allocator<int>, Links::Double, Size::Untracked> lst(
+        &trace);
+    std::istringstream numbers("1 2 3 4 5");
+    lst.push_back_n(std::istream_iterator<int>(numbers),
+                    std::istream_iterator<int>());
+    std::vector<int> out;
+    lst.pop_front_n(2, std::back_inserter(out));
+    lst.pop_front_n(10, std::back_inserter(out));
+
+    std::vector<ListTrace::Record> expected = {
+        {Op::PushBackN, 5}, {Op::PopFrontN, 2}, {Op::PopFrontN, 3}};
+    EXPECT_TRUE(trace.records() == expected);
+    EXPECT_TRUE(out == std::vector<int>({1, 2, 3, 4, 5}) && lst.empty());
+
+    // Single has no pop_back; replay pops the front instead.
+    ListTrace pops;
+    pops.record(Op::PushBackN, 4);
+    pops.record(Op::PopBack);
+    pops.record(Op::PushFront);
+    pops.record(Op::PopBack);
+    List<int, std::allocator<int>, Links::Single> single;
+    EXPECT_TRUE(replay_trace(pops, single, [](int) {}) == 0);
+    EXPECT_TRUE(single.size() == 3);
+  }
+
+  {
+    TracingList<int> lst(nullptr);
+    lst.push_back(1);
+    lst.pop_back();
+    EXPECT_TRUE(lst.empty() && lst.trace() == nullptr);
+
+    ListTrace trace;
+    trace.record(Op::Iterate, uint64_t(1) << 40);
+    EXPECT_TRUE(trace.records().front().arg == uint64_t(1) << 40);
+
+    std::stringstream bad("LTR0");
+    bool thrown = false;
+    try {
+      ListTrace::load(bad);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+
+    std::stringstream file;
+    trace.save(file);
+    std::string bytes = file.str();
+    std::stringstream cut(bytes.substr(0, bytes.size() - 1));
+    thrown = false;
+    try {
+      ListTrace::load(cut);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+
+    // A body length near 2^63 with nothing behind it.
+    std::stringstream huge(std::string("LTR1\x04\x01") +
+                           std::string(8, '\xff') + "\x7f");
+    thrown = false;
+    try {
+      ListTrace::load(huge);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+  }
+}
+
+void ADAPTIVE() {
+  std::cout << "Checking adaptive list: \n";
+  {
+    AdaptiveList<std::string> lst;
+    for (int i = 0; i < 100; ++i) {
+      lst.push_back(std::to_string(i));
+    }
+    size_t total = 0;
+    for (int pass = 0; pass < 4; ++pass) {
+      for (const std::string& s : lst) {
+        total += s.size();
+      }
+    }
+    EXPECT_FALSE(lst.frozen());
+
+    std::vector<std::string> seen;
+    for (const std::string& s : lst) {
+      seen.push_back(s);
+    }
+    EXPECT_TRUE(lst.frozen());
+    EXPECT_TRUE(seen.size() == 100 && seen.front() == "0" &&
+                seen.back() == "99");
+    EXPECT_TRUE(lst.size() == 100 && lst.front() == "0" && lst.back() == "99");
+
+    *std::next(lst.begin(), 5) = "five";
+    EXPECT_TRUE(lst.frozen());
+
+    auto it = lst.insert(std::next(lst.cbegin(), 10), "ten");
+    EXPECT_FALSE(lst.frozen());
+    EXPECT_TRUE(*it == "ten" && *std::prev(it) == "9" &&
+                *std::next(lst.begin(), 5) == "five");
+    EXPECT_TRUE(lst.size() == 101);
+
+    lst.freeze();
+    it = lst.erase(std::next(lst.cbegin(), 10));
+    EXPECT_TRUE(!lst.frozen() && *it == "10" && lst.size() == 100);
+  }
+
+  {
+    AdaptiveList<int> lst;
+    for (int i = 0; i < 64; ++i) {
+      lst.push_back(i);
+    }
+    auto held = lst.begin();
+    for (int pass = 0; pass < 10; ++pass) {
+      for (int x : lst) {
+        std::ignore = x;
+      }
+    }
+    EXPECT_TRUE(!lst.frozen() && *held == 0);
+    held = lst.end();
+    lst.for_each([](int) {});
+    EXPECT_FALSE(lst.frozen());
+  }
+
+  {
+    AdaptiveList<int> lst;
+    for (int i = 0; i < 64; ++i) {
+      lst.push_back(i);
+    }
+    lst.freeze();
+    lst.push_back(64);
+
+    // The freeze did not pay off, so the next one takes twice as many
+    // traversals.
+    for (int pass = 0; pass < 5; ++pass) {
+      lst.for_each([](int) {});
+    }
+    EXPECT_FALSE(lst.frozen());
+    for (int pass = 0; pass < 4; ++pass) {
+      lst.for_each([](int) {});
+    }
+    EXPECT_TRUE(lst.frozen());
+
+    int sum = 0;
+    lst.for_each([&sum](int x) { sum += x; });
+    EXPECT_TRUE(sum == 64 * 65 / 2);
+    auto descending = std::views::reverse(std::views::iota(0, 65));
+    EXPECT_TRUE(std::equal(lst.rbegin(), lst.rend(), descending.begin()));
+
+    AdaptiveList<int> copy = lst;
+    EXPECT_TRUE(copy == lst && !copy.frozen());
+    AdaptiveList<int> moved = std::move(lst);
+    EXPECT_TRUE(moved == copy && moved.frozen() && lst.empty());
+    moved.clear();
+    EXPECT_TRUE(moved.empty() && !moved.frozen());
+
+    AdaptiveList<int> small = {1, 2, 3};
+    for (int pass = 0; pass < 10; ++pass) {
+      small.for_each([](int) {});
+    }
+    EXPECT_FALSE(small.frozen());
+  }
+
+  {
+    // Iterators may outlive their list.
+    AdaptiveList<int>::iterator it;
+    AdaptiveList<int>::const_iterator end;
+    {
+      AdaptiveList<int> lst = {1, 2, 3};
+      it = lst.begin();
+      end = lst.cend();
+      EXPECT_TRUE(*it == 1);
+    }
+    it = AdaptiveList<int>::iterator();
+  }
+
+  {
+    // Iterators follow the elements through move and swap.
+    AdaptiveList<int> a;
+    for (int i = 0; i < 64; ++i) {
+      a.push_back(i);
+    }
+    auto it = a.begin();
+    AdaptiveList<int> b(std::move(a));
+    for (int pass = 0; pass < 10; ++pass) {
+      for (int x : b) {
+        std::ignore = x;
+      }
+    }
+    EXPECT_TRUE(!b.frozen() && *it == 0);
+
+    for (int i = 0; i < 64; ++i) {
+      a.push_back(i);
+    }
+    for (int pass = 0; pass < 10; ++pass) {
+      a.for_each([](int) {});
+    }
+    EXPECT_TRUE(a.frozen());
+
+    a.swap(b);
+    for (int pass = 0; pass < 10; ++pass) {
+      b.for_each([](int) {});
+      a.for_each([](int) {});
+    }
+    EXPECT_TRUE(!a.frozen() && b.frozen() && *it == 0);
+
+    AdaptiveList<int> c;
+    c = std::move(a);
+    for (int pass = 0; pass < 10; ++pass) {
+      c.for_each([](int) {});
+    }
+    EXPECT_TRUE(!c.frozen() && *++it == 1);
+
+    it = c.end();
+    for (int pass = 0; pass < 10; ++pass) {
+      c.for_each([](int) {});
+    }
+    EXPECT_FALSE(c.frozen());
+    it = AdaptiveList<int>::iterator();
+    c.for_each([](int) {});
+    EXPECT_TRUE(c.frozen());
+  }
+
+  {
+    // A thaw that runs out of nodes halfway leaves the list frozen.
+    AdaptiveList<std::string, FailingAllocator<std::string>> lst;
+    for (int i = 0; i < 20; ++i) {
+      lst.push_back(std::string(32, static_cast<char>('a' + i)));
+    }
+    for (int pass = 0; pass < 5; ++pass) {
+      lst.for_each([](const std::string&) {});
+    }
+    EXPECT_TRUE(lst.frozen());
+
+    FailingAllocatorBudget::allocations_left = 7;
+    bool thrown = false;
+    try {
+      lst.push_back("late");
+    } catch (const std::bad_alloc&) {
+      thrown = true;
+    }
+    FailingAllocatorBudget::allocations_left = SIZE_MAX;
+    EXPECT_TRUE(thrown && lst.frozen() && lst.size() == 20);
+
+    bool intact = true;
+    char expected = 'a';
+    lst.for_each([&](const std::string& s) {
+      intact = intact && s == std::string(32, expected++);
+    });
+    EXPECT_TRUE(intact);
+
+    lst.push_back("late");
+    EXPECT_TRUE(!lst.frozen() && lst.size() == 21 && lst.front()[0] == 'a' &&
+                lst.back() == "late");
+  }
+}
+
+void DEFERRED() {
+  std::cout << "Checking deferred destruction: \n";
+  auto shared = std::make_shared<int>(7);
+  {
+    DeferredReclaimer reclaimer;
+    {
+      DeferredList<std::shared_ptr<int>> lst(reclaimer);
+      for (int i = 0; i < 20000; ++i) {
+        lst.push_back(shared);
+      }
+      DeferredList<std::shared_ptr<int>> copy = lst;
+      EXPECT_TRUE(copy.size() == 20000 && copy.reclaimer() == &reclaimer);
+    }
+    reclaimer.flush();
+    EXPECT_TRUE(shared.use_count() == 1 && reclaimer.backlog() == 0);
+  }
+
+  {
+    DeferredReclaimerOptions options;
+    options.max_backlog = 100;
+    options.background_thread = false;
+    DeferredReclaimer reclaimer(options);
+
+    {
+      DeferredList<std::shared_ptr<int>> big(reclaimer);
+      for (int i = 0; i < 1000; ++i) {
+        big.push_back(shared);
+      }
+    }
+    EXPECT_TRUE(shared.use_count() == 1 && reclaimer.backlog() == 0);
+
+    {
+      DeferredList<std::shared_ptr<int>> small(reclaimer);
+      for (int i = 0; i < 50; ++i) {
+        small.push_back(shared);
+      }
+      DeferredList<std::shared_ptr<int>> moved = std::move(small);
+    }
+    EXPECT_TRUE(shared.use_count() == 51 && reclaimer.backlog() == 50);
+
+    EXPECT_TRUE(reclaimer.reclaim(20) == 20);
+    EXPECT_TRUE(shared.use_count() == 31 && reclaimer.backlog() == 30);
+
+    List<std::shared_ptr<int>> plain(80, shared);
+    EXPECT_FALSE(reclaimer.retire(std::move(plain)));
+    EXPECT_TRUE(plain.empty() && shared.use_count() == 31);
+
+    reclaimer.flush();
+    EXPECT_TRUE(shared.use_count() == 1 && reclaimer.backlog() == 0);
+
+    List<std::shared_ptr<int>> later(10, shared);
+    EXPECT_TRUE(reclaimer.retire(std::move(later)));
+  }
+  EXPECT_TRUE(shared.use_count() == 1);
+
+  {
+    DeferredList<int> inline_list;
+    inline_list.push_back(1);
+    EXPECT_TRUE(inline_list.reclaimer() == nullptr);
+  }
+
+  {
+    // Assignment keeps the target's reclaimer.
+    DeferredReclaimerOptions manual;
+    manual.background_thread = false;
+    DeferredReclaimer first(manual);
+    DeferredReclaimer second(manual);
+    {
+      DeferredList<int> a(first);
+      DeferredList<int> b(second);
+      DeferredList<int> plain;
+      for (int i = 0; i < 10; ++i) {
+        b.push_back(i);
+      }
+
+      a = b;
+      EXPECT_TRUE(a.size() == 10 && a.reclaimer() == &first);
+      a = plain;
+      EXPECT_TRUE(a.empty() && a.reclaimer() == &first);
+      a = std::move(b);
+      EXPECT_TRUE(a.size() == 10 && a.reclaimer() == &first &&
+                  b.reclaimer() == &second);
+
+      plain = a;
+      EXPECT_TRUE(plain.reclaimer() == nullptr);
+      DeferredList<int> moved(std::move(plain));
+      EXPECT_TRUE(moved.reclaimer() == nullptr);
+    }
+    EXPECT_TRUE(first.backlog() == 10 && second.backlog() == 0);
+  }
+}
+
+void PROFILING() {
+  std::cout << "Checking profiling allocator: \n";
+
+  {
+    ProfileOptions options;
+    options.sample_every = 1;
+    options.short_lived = std::chrono::hours(1);
+    auto profile = std::make_shared<AllocationProfile>(options);
+
+    List<int, ProfilingAllocator<int>> queue(
+        ProfilingAllocator<int>(profile, "queue"));
+    List<int, ProfilingAllocator<int>> index(
+        ProfilingAllocator<int>(profile, "index"));
+    EXPECT_FALSE(queue.get_allocator() == index.get_allocator());
+
+    for (int i = 0; i < 100; ++i) {
+      queue.push_back(i);
+    }
+    for (int i = 0; i < 50; ++i) {
+      queue.pop_front();
+    }
+    index.push_back(7);
+    EXPECT_TRUE(queue.front() == 50 && queue.back() == 99);
+
+    auto sites = profile->summary();
+    EXPECT_TRUE(sites.size() == 2 && sites[0].label == "index" &&
+                sites[1].label == "queue");
+    const auto& q = sites[1];
+    EXPECT_TRUE(q.allocations == 100 && q.deallocations == 50 &&
+                q.live == 50);
+    EXPECT_TRUE(q.average_bytes >= sizeof(int) &&
+                q.live_bytes == 50 * static_cast<uint64_t>(q.average_bytes));
+    EXPECT_TRUE(q.sampled == 50 && q.short_lived_ratio == 1.0);
+    EXPECT_TRUE(std::accumulate(q.lifetime_histogram.begin(),
+                                q.lifetime_histogram.end(),
+                                uint64_t(0)) == 50);
+    EXPECT_TRUE(sites[0].live == 1 && sites[0].sampled == 0);
+
+    List<int, ProfilingAllocator<int>> copy = queue;
+    EXPECT_TRUE(copy.get_allocator() == queue.get_allocator());
+    copy.clear();
+    queue.clear();
+    sites = profile->summary();
+    EXPECT_TRUE(sites[1].live == 0 && sites[1].deallocations == 150);
+
+    std::ostringstream out;
+    profile->dump(out);
+    EXPECT_TRUE(out.str().find("queue: live=0") != std::string::npos);
+  }
+
+  {
+    // Each profile keeps its own sampling rate when a thread interleaves
+    // allocations from both.
+    ProfileOptions often;
+    often.sample_every = 4;
+    ProfileOptions rarely;
+    rarely.sample_every = 1000;
+    auto first = std::make_shared<AllocationProfile>(often);
+    auto second = std::make_shared<AllocationProfile>(rarely);
+    List<int, ProfilingAllocator<int>> a(ProfilingAllocator<int>(first, "a"));
+    List<int, ProfilingAllocator<int>> b(ProfilingAllocator<int>(second, "b"));
+    for (int i = 0; i < 100; ++i) {
+      a.push_back(i);
+      b.push_back(i);
+    }
+    a.clear();
+    b.clear();
+    EXPECT_TRUE(first->summary()[0].sampled == 25 &&
+                second->summary()[0].sampled == 1);
+  }
+
+  {
+    // Lists with the same label share one Site, which goes away with the
+    // last of them and leaves its counts to the label.
+    auto profile = std::make_shared<AllocationProfile>();
+    bool shared = true;
+    for (int round = 0; round < 100; ++round) {
+      List<int, ProfilingAllocator<int>> first(
+          ProfilingAllocator<int>(profile, "request"));
+      List<int, ProfilingAllocator<int>> second(
+          ProfilingAllocator<int>(profile, "request"));
+      first.push_back(round);
+      second.push_back(round);
+      second.push_back(round);
+      first.append(std::move(second));
+      shared = shared && first.get_allocator() == second.get_allocator() &&
+               profile->live_sites() == 1;
+    }
+    EXPECT_TRUE(shared && profile->live_sites() == 0);
+
+    List<int, ProfilingAllocator<int>> later(
+        ProfilingAllocator<int>(profile, "request"));
+    later.push_back(1);
+    auto sites = profile->summary();
+    EXPECT_TRUE(sites.size() == 1 && sites[0].label == "request" &&
+                sites[0].allocations == 301 && sites[0].live == 1);
+    EXPECT_TRUE(profile->live_sites() == 1);
+  }
+
+  {
+    ProfileOptions options;
+    options.sample_every = 0;
+    auto profile = std::make_shared<AllocationProfile>(options);
+    ProfilingAllocator<int> alloc(profile, "shared");
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([alloc] {
+        List<int, ProfilingAllocator<int>> lst(alloc);
+        for (int i = 0; i < 10000; ++i) {
+          lst.push_back(i);
+          if (i % 2 == 1) {
+            lst.pop_front();
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    auto sites = profile->summary();
+    EXPECT_TRUE(sites.size() == 1 && sites[0].allocations == 40000 &&
+                sites[0].live == 0 && sites[0].sampled == 0);
+  }
+
+  {
+    struct alignas(64) Wide {
+      int val = 0;
+    };
+    auto profile = std::make_shared<AllocationProfile>();
+    List<Wide, ProfilingAllocator<Wide>> lst(
+        ProfilingAllocator<Wide>(profile, "wide"));
+    for (int i = 0; i < 10; ++i) {
+      lst.push_back(Wide{i});
+    }
+    bool aligned = true;
+    for (const Wide& val : lst) {
+      aligned = aligned && reinterpret_cast<uintptr_t>(&val) % 64 == 0;
+    }
+    EXPECT_TRUE(aligned && profile->summary()[0].live == 10);
+  }
+}
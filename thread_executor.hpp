@@ -0,0 +1,59 @@
+#pragma once
+
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Minimal executor for List::parallel_copy and friends: bulk(n, func) runs
+// func(0) on the calling thread and func(1) .. func(n - 1) on fresh
+// threads, joins them all and rethrows the exception of the lowest task
+// that threw, if any.
+class ThreadExecutor {
+ private:
+  size_t threads_;
+
+ public:
+  explicit ThreadExecutor(size_t threads = std::thread::hardware_concurrency())
+      : threads_(threads == 0 ? 1 : threads) {}
+
+  size_t concurrency() const { return threads_; }
+
+  template <typename F>
+  void bulk(size_t n, F func) {
+    std::vector<std::exception_ptr> errors(n);
+    std::vector<std::thread> workers;
+    workers.reserve(n);
+
+    auto run = [&func, &errors](size_t i) {
+      try {
+        func(i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    };
+
+    try {
+      for (size_t i = 1; i < n; i++) {
+        workers.emplace_back(run, i);
+      }
+    } catch (...) {
+      for (auto& worker : workers) {
+        worker.join();
+      }
+      throw;
+    }
+
+    if (n > 0) {
+      run(0);
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    for (const std::exception_ptr& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+  }
+};
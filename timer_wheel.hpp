@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "list.hpp"
+
+class TimerWheel;
+
+// Intrusive timer: embed or derive, then hand it to a TimerWheel. A timer
+// is linked into at most one wheel slot and cancels itself on destruction.
+class Timer : public TruncatedNode {
+ private:
+  TimerWheel* wheel_ = nullptr;
+  uint64_t expiry_ = 0;
+  int level_ = 0;
+
+  friend class TimerWheel;
+
+  void unlink() {
+    TruncatedNode::unlink(this);
+    next = nullptr;
+    prev = nullptr;
+  }
+
+ public:
+  Timer() : TruncatedNode(nullptr, nullptr) {}
+
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
+
+  inline ~Timer();
+
+  bool scheduled() const { return next != nullptr; }
+
+  uint64_t expiry() const { return expiry_; }
+};
+
+// Hierarchical timing wheel over integer ticks: kLevels levels of kSlots
+// slots, each slot a sentinel TruncatedNode heading a ring of timers. A
+// timer sits on the level of the highest byte in which its expiry differs
+// from the current tick, so schedule and cancel are O(1) relinks. Every
+// tick expires one level-0 slot by splicing its whole ring out at once;
+// when the lower bytes of the tick wrap, the matching slot of the level
+// above is spliced out and redistributed. Timers further out than the top
+// level covers wait in the top level's last slot and get re-placed each
+// time it cascades. Per-level counts let advance jump over stretches where
+// the lower levels are empty instead of walking them tick by tick.
+class TimerWheel {
+ public:
+  static constexpr int kLevels = 4;
+  static constexpr int kSlotBits = 8;
+  static constexpr size_t kSlots = size_t(1) << kSlotBits;
+
+  explicit TimerWheel(uint64_t now = 0) : now_(now) {}
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Timers still scheduled are left unscheduled.
+  ~TimerWheel() {
+    for (auto& level : slots_) {
+      for (TruncatedNode& slot : level) {
+        while (slot.next != &slot) {
+          Timer* timer = static_cast<Timer*>(slot.next);
+          timer->unlink();
+          timer->wheel_ = nullptr;
+        }
+      }
+    }
+  }
+
+  uint64_t now() const { return now_; }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  // (Re)schedules timer to fire at tick expiry. Expiries that are not in
+  // the future fire on the next tick.
+  void schedule(Timer& timer, uint64_t expiry) {
+    if (timer.scheduled()) {
+      remove(&timer);
+    }
+    timer.expiry_ = expiry;
+    place(&timer, now_ + 1);
+  }
+
+  bool cancel(Timer& timer) {
+    if (!timer.scheduled()) {
+      return false;
+    }
+    remove(&timer);
+    return true;
+  }
+
+  // Moves the wheel to tick now, calling on_expire(Timer&) for every timer
+  // that comes due, tick by tick. The timer is unscheduled by the time
+  // on_expire sees it; callbacks may schedule and cancel timers freely,
+  // including ones due in the same tick.
+  template <typename F>
+  void advance(uint64_t now, F on_expire) {
+    while (now_ < now) {
+      // Skip to just before the next tick that has anything to do.
+      int busy = 0;
+      while (busy < kLevels && level_size_[busy] == 0) {
+        busy++;
+      }
+      if (busy == kLevels) {
+        now_ = now;
+        return;
+      }
+      if (busy > 0) {
+        uint64_t boundary = now_ | ((uint64_t(1) << (kSlotBits * busy)) - 1);
+        if (boundary >= now) {
+          now_ = now;
+          return;
+        }
+        now_ = boundary;
+      }
+
+      ++now_;
+      for (int level = 1; level < kLevels; ++level) {
+        if ((now_ & ((uint64_t(1) << (kSlotBits * level)) - 1)) != 0) {
+          break;
+        }
+        cascade(level);
+      }
+
+      TruncatedNode expired;
+      TruncatedNode::move_ring(slot_of(0, now_), expired);
+      while (expired.next != &expired) {
+        Timer* timer = static_cast<Timer*>(expired.next);
+        remove(timer);
+        on_expire(*timer);
+      }
+    }
+  }
+
+ private:
+  TruncatedNode slots_[kLevels][kSlots];
+  size_t level_size_[kLevels] = {};
+  uint64_t now_;
+  size_t size_ = 0;
+
+  TruncatedNode& slot_of(int level, uint64_t tick) {
+    return slots_[level][(tick >> (kSlotBits * level)) & (kSlots - 1)];
+  }
+
+  // Timers due before earliest go to its slot. Cascading passes the current
+  // tick, whose level-0 slot is expired right after.
+  void place(Timer* timer, uint64_t earliest) {
+    uint64_t expiry = std::max(timer->expiry_, earliest);
+    uint64_t diff = expiry ^ now_;
+
+    TruncatedNode* slot = nullptr;
+    int level = 0;
+    while (level < kLevels && (diff >> (kSlotBits * (level + 1))) != 0) {
+      level++;
+    }
+    if (level < kLevels) {
+      slot = &slot_of(level, expiry);
+    } else if (expiry - now_ < (uint64_t(1) << (kSlotBits * kLevels))) {
+      // Close, but across a top level wrap: its top slot comes round first.
+      level = kLevels - 1;
+      slot = &slot_of(level, expiry);
+    } else {
+      // Beyond the top level: the slot cascaded last in its round.
+      level = kLevels - 1;
+      slot = &slot_of(level, now_ - (uint64_t(1) << (kSlotBits * level)));
+    }
+
+    TruncatedNode::link_before(slot, timer);
+
+    timer->wheel_ = this;
+    timer->level_ = level;
+    level_size_[level]++;
+    size_++;
+  }
+
+  void remove(Timer* timer) {
+    timer->unlink();
+    timer->wheel_ = nullptr;
+    level_size_[timer->level_]--;
+    size_--;
+  }
+
+  void cascade(int level) {
+    TruncatedNode pending;
+    TruncatedNode::move_ring(slot_of(level, now_), pending);
+    while (pending.next != &pending) {
+      Timer* timer = static_cast<Timer*>(pending.next);
+      remove(timer);
+      place(timer, now_);
+    }
+  }
+};
+
+Timer::~Timer() {
+  if (scheduled()) {
+    wheel_->cancel(*this);
+  }
+}
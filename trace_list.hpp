@@ -0,0 +1,441 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "list.hpp"
+
+// Compact binary log of the operations applied to one List: which end was
+// pushed or popped, batch sizes and how many elements each traversal
+// visited. Element values are not kept, only sizeof the element type.
+//
+// Every record is one byte, the op in the low kOpBits bits and the
+// argument above them; arguments that do not fit are escaped and follow as
+// a LEB128 varint. Plain pushes and pops, and scans shorter than 31
+// elements, thus cost a single byte.
+class ListTrace {
+ public:
+  enum class Op : uint8_t {
+    PushBack,
+    PushFront,
+    PopBack,
+    PopFront,
+    PushBackN,
+    PopFrontN,
+    Iterate,
+    Clear,
+  };
+
+  struct Record {
+    Op op;
+    uint64_t arg;
+
+    bool operator==(const Record&) const = default;
+  };
+
+  ListTrace() = default;
+
+  explicit ListTrace(size_t element_size) : element_size_(element_size) {}
+
+  size_t element_size() const { return element_size_; }
+
+  void set_element_size(size_t element_size) { element_size_ = element_size; }
+
+  size_t op_count() const { return op_count_; }
+
+  size_t byte_size() const { return bytes_.size(); }
+
+  void record(Op op, uint64_t arg = 0) {
+    if (arg < kEscape) {
+      bytes_.push_back(static_cast<uint8_t>(static_cast<uint8_t>(op) |
+                                            (arg << kOpBits)));
+    } else {
+      bytes_.push_back(static_cast<uint8_t>(static_cast<uint8_t>(op) |
+                                            (kEscape << kOpBits)));
+      put_varint(bytes_, arg - kEscape);
+    }
+    op_count_++;
+  }
+
+  // Calls visit(Record) for every op in order.
+  template <typename F>
+  void for_each(F visit) const {
+    size_t pos = 0;
+    while (pos < bytes_.size()) {
+      uint8_t byte = bytes_[pos++];
+      Record rec{static_cast<Op>(byte & kOpMask), uint64_t(byte >> kOpBits)};
+      if (rec.arg == kEscape) {
+        rec.arg += get_varint(bytes_, pos);
+      }
+      visit(rec);
+    }
+  }
+
+  std::vector<Record> records() const {
+    std::vector<Record> result;
+    result.reserve(op_count_);
+    for_each([&result](const Record& rec) { result.push_back(rec); });
+    return result;
+  }
+
+  void save(std::ostream& out) const {
+    std::vector<uint8_t> header(kMagic, kMagic + sizeof(kMagic));
+    put_varint(header, element_size_);
+    put_varint(header, op_count_);
+    put_varint(header, bytes_.size());
+    out.write(reinterpret_cast<const char*>(header.data()),
+              static_cast<std::streamsize>(header.size()));
+    out.write(reinterpret_cast<const char*>(bytes_.data()),
+              static_cast<std::streamsize>(bytes_.size()));
+  }
+
+  // Throws std::runtime_error on anything that is not a whole trace.
+  static ListTrace load(std::istream& in) {
+    char magic[sizeof(kMagic)] = {};
+    in.read(magic, sizeof(magic));
+    if (!in || !std::equal(magic, magic + sizeof(magic), kMagic)) {
+      throw std::runtime_error("ListTrace: bad magic");
+    }
+
+    ListTrace trace(read_varint(in));
+    trace.op_count_ = read_varint(in);
+    // The body grows a chunk at a time, so a corrupt length runs into the
+    // end of the stream instead of allocating whatever it claims.
+    uint64_t length = read_varint(in);
+    while (trace.bytes_.size() < length) {
+      size_t done = trace.bytes_.size();
+      size_t chunk = static_cast<size_t>(
+          std::min<uint64_t>(length - done, kLoadChunk));
+      trace.bytes_.resize(done + chunk);
+      in.read(reinterpret_cast<char*>(trace.bytes_.data() + done),
+              static_cast<std::streamsize>(chunk));
+      if (!in) {
+        throw std::runtime_error("ListTrace: truncated");
+      }
+    }
+
+    size_t ops = 0;
+    trace.for_each([&ops](const Record&) { ops++; });
+    if (ops != trace.op_count_) {
+      throw std::runtime_error("ListTrace: op count mismatch");
+    }
+    return trace;
+  }
+
+ private:
+  static constexpr char kMagic[4] = {'L', 'T', 'R', '1'};
+  static constexpr int kOpBits = 3;
+  static constexpr uint8_t kOpMask = (1 << kOpBits) - 1;
+  static constexpr uint64_t kEscape = (1 << (8 - kOpBits)) - 1;
+  static constexpr size_t kLoadChunk = size_t(1) << 16;
+
+  std::vector<uint8_t> bytes_;
+  size_t element_size_ = 0;
+  size_t op_count_ = 0;
+
+  static void put_varint(std::vector<uint8_t>& out, uint64_t val) {
+    while (val >= 0x80) {
+      out.push_back(static_cast<uint8_t>(val | 0x80));
+      val >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(val));
+  }
+
+  static uint64_t get_varint(const std::vector<uint8_t>& in, size_t& pos) {
+    uint64_t val = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (pos == in.size()) {
+        throw std::runtime_error("ListTrace: truncated varint");
+      }
+      uint8_t byte = in[pos++];
+      val |= uint64_t(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return val;
+      }
+    }
+    throw std::runtime_error("ListTrace: overlong varint");
+  }
+
+  static uint64_t read_varint(std::istream& in) {
+    std::vector<uint8_t> buf;
+    int byte = 0;
+    do {
+      byte = in.get();
+      if (byte == std::istream::traits_type::eof() || buf.size() == 10) {
+        throw std::runtime_error("ListTrace: truncated header");
+      }
+      buf.push_back(static_cast<uint8_t>(byte));
+    } while ((byte & 0x80) != 0);
+    size_t pos = 0;
+    return get_varint(buf, pos);
+  }
+};
+
+// List that logs its operations into a ListTrace. Recording is opt-in: with
+// a null trace every operation goes straight to the list. Ops are recorded
+// after they succeed, so a throwing push leaves no record. Reads through
+// list() are not recorded; traversals that should be are for_each and
+// find_if. One trace per list.
+template <typename T, typename Alloc = std::allocator<T>,
+          typename LinkPolicy = Links::Double,
+          typename SizePolicy = Size::Tracked>
+class TracingList {
+ public:
+  using list_type = List<T, Alloc, LinkPolicy, SizePolicy>;
+  using value_type = T;
+  using allocator_type = Alloc;
+  using Op = ListTrace::Op;
+
+  explicit TracingList(ListTrace* trace, const Alloc& alloc = Alloc())
+      : list_(alloc), trace_(nullptr) {
+    set_trace(trace);
+  }
+
+  const list_type& list() const { return list_; }
+
+  ListTrace* trace() const { return trace_; }
+
+  void set_trace(ListTrace* trace) {
+    trace_ = trace;
+    if (trace_ != nullptr) {
+      trace_->set_element_size(sizeof(T));
+    }
+  }
+
+  size_t size() const { return list_.size(); }
+
+  bool empty() const { return list_.empty(); }
+
+  T& front() { return list_.front(); }
+
+  const T& front() const { return list_.front(); }
+
+  T& back() { return list_.back(); }
+
+  const T& back() const { return list_.back(); }
+
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    list_.emplace_back(std::forward<Args>(args)...);
+    record(Op::PushBack);
+  }
+
+  template <typename... Args>
+  void emplace_front(Args&&... args) {
+    list_.emplace_front(std::forward<Args>(args)...);
+    record(Op::PushFront);
+  }
+
+  void push_back(const T& val) {
+    list_.push_back(val);
+    record(Op::PushBack);
+  }
+
+  void push_back(T&& val) {
+    list_.push_back(std::move(val));
+    record(Op::PushBack);
+  }
+
+  void push_front(const T& val) {
+    list_.push_front(val);
+    record(Op::PushFront);
+  }
+
+  void push_front(T&& val) {
+    list_.push_front(std::move(val));
+    record(Op::PushFront);
+  }
+
+  void pop_back() {
+    list_.pop_back();
+    record(Op::PopBack);
+  }
+
+  void pop_front() {
+    list_.pop_front();
+    record(Op::PopFront);
+  }
+
+  // Batches from single-pass iterators, and pop_front_n, count the
+  // elements as they go by, so neither needs size().
+  template <typename InputIt>
+  void push_back_n(InputIt first, InputIt last) {
+    if constexpr (std::forward_iterator<InputIt>) {
+      size_t count = static_cast<size_t>(std::distance(first, last));
+      list_.push_back_n(first, last);
+      record(Op::PushBackN, count);
+    } else {
+      size_t count = 0;
+      list_.push_back_n(Counted<InputIt>{first, &count},
+                        Counted<InputIt>{last, &count});
+      record(Op::PushBackN, count);
+    }
+  }
+
+  template <typename OutputIt>
+  OutputIt pop_front_n(size_t n, OutputIt out) {
+    size_t count = 0;
+    out = list_.pop_front_n(n, Counted<OutputIt>{out, &count}).it;
+    record(Op::PopFrontN, count);
+    return out;
+  }
+
+  void clear() {
+    list_.clear();
+    record(Op::Clear);
+  }
+
+  template <typename F>
+  void for_each(F func) {
+    size_t visited = 0;
+    for (T& val : list_) {
+      func(val);
+      visited++;
+    }
+    record(Op::Iterate, visited);
+  }
+
+  // Records a traversal of the elements up to and including the match.
+  template <typename Pred>
+  typename list_type::const_iterator find_if(Pred pred) const {
+    size_t visited = 0;
+    auto it = list_.begin();
+    for (; it != list_.end(); ++it) {
+      visited++;
+      if (pred(*it)) {
+        break;
+      }
+    }
+    record(Op::Iterate, visited);
+    return it;
+  }
+
+ private:
+  list_type list_;
+  ListTrace* trace_;
+
+  // Iterator that counts its increments into *count.
+  template <typename It>
+  struct Counted {
+    It it;
+    size_t* count;
+
+    decltype(auto) operator*() { return *it; }
+
+    Counted& operator++() {
+      ++it;
+      ++*count;
+      return *this;
+    }
+
+    bool operator==(const Counted& other) const { return it == other.it; }
+  };
+
+  void record(Op op, uint64_t arg = 0) const {
+    if (trace_ != nullptr) {
+      trace_->record(op, arg);
+    }
+  }
+};
+
+// Applies trace to list, which should start out empty. Pushed elements are
+// value-initialized and each traversal walks its recorded number of
+// elements from the front, handing them to visit. Lists without the batch
+// operations replay batches one element at a time, and Links::Single lists,
+// which have no pop_back, pop the front instead: every replayed element is
+// value-initialized, so the contents come out the same.
+//
+// A trace attached to a list that already held elements, or a well-formed
+// but made-up file, can pop more than it pushed. Pops past the replayed
+// size are skipped; the return value is how many elements they would
+// have removed.
+template <typename ListT, typename Visit>
+size_t replay_trace(const ListTrace& trace, ListT& list, Visit visit) {
+  using T = typename ListT::value_type;
+  using Op = ListTrace::Op;
+
+  std::vector<T> popped;
+  size_t live = 0;
+  size_t skipped = 0;
+
+  // Clamps a pop of count elements to what is there.
+  auto take = [&live, &skipped](uint64_t count) {
+    uint64_t taken = std::min<uint64_t>(count, live);
+    skipped += static_cast<size_t>(count - taken);
+    live -= static_cast<size_t>(taken);
+    return taken;
+  };
+
+  trace.for_each([&](const ListTrace::Record& rec) {
+    switch (rec.op) {
+      case Op::PushBack:
+        list.push_back(T());
+        live++;
+        break;
+      case Op::PushFront:
+        list.push_front(T());
+        live++;
+        break;
+      case Op::PopBack:
+        if (take(1) != 0) {
+          if constexpr (requires { list.pop_back(); }) {
+            list.pop_back();
+          } else {
+            list.pop_front();
+          }
+        }
+        break;
+      case Op::PopFront:
+        if (take(1) != 0) {
+          list.pop_front();
+        }
+        break;
+      case Op::PushBackN:
+        if constexpr (requires {
+                        list.push_back_n(popped.begin(), popped.end());
+                      }) {
+          auto values = std::views::iota(uint64_t(0), rec.arg) |
+                        std::views::transform([](uint64_t) { return T(); });
+          list.push_back_n(values.begin(), values.end());
+        } else {
+          for (uint64_t i = 0; i < rec.arg; i++) {
+            list.push_back(T());
+          }
+        }
+        live += static_cast<size_t>(rec.arg);
+        break;
+      case Op::PopFrontN: {
+        uint64_t count = take(rec.arg);
+        if constexpr (requires { list.pop_front_n(0, popped.begin()); }) {
+          popped.clear();
+          list.pop_front_n(count, std::back_inserter(popped));
+        } else {
+          for (uint64_t i = 0; i < count; i++) {
+            list.pop_front();
+          }
+        }
+        break;
+      }
+      case Op::Iterate: {
+        uint64_t left = rec.arg;
+        for (auto it = list.begin(); left > 0 && it != list.end();
+             ++it, --left) {
+          visit(*it);
+        }
+        break;
+      }
+      case Op::Clear:
+        list.clear();
+        live = 0;
+        break;
+    }
+  });
+  return skipped;
+}
@@ -2,6 +2,7 @@
 #pragma once
 #include <new>
 #include <iostream>
+#include <memory_resource>
 
 #include "memory_utils.hpp"
 
@@ -169,6 +170,84 @@ struct ThrowingAccountant : public Accountant {
   }
 };
 
+template <typename T>
+struct NoexceptAllocator {
+  using value_type = T;
+
+  NoexceptAllocator() = default;
+
+  template <typename U>
+  NoexceptAllocator(const NoexceptAllocator<U>&) {}
+
+  T* allocate(size_t n) noexcept {
+    void* ptr = std::malloc(n * sizeof(T));
+    if (ptr == nullptr) {
+      std::abort();
+    }
+    return static_cast<T*>(ptr);
+  }
+
+  void deallocate(T* ptr, size_t) noexcept { std::free(ptr); }
+
+  template <typename U>
+  bool operator==(const NoexceptAllocator<U>&) const {
+    return true;
+  }
+};
+
+// Allocator that throws std::bad_alloc once allocations_left allocations
+// have succeeded. The budget is shared by every rebound copy.
+struct FailingAllocatorBudget {
+  static size_t allocations_left;
+};
+
+template <typename T>
+struct FailingAllocator {
+  using value_type = T;
+
+  FailingAllocator() = default;
+
+  template <typename U>
+  FailingAllocator(const FailingAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    if (FailingAllocatorBudget::allocations_left == 0) {
+      throw std::bad_alloc();
+    }
+    FailingAllocatorBudget::allocations_left--;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* ptr, size_t n) { std::allocator<T>().deallocate(ptr, n); }
+
+  template <typename U>
+  bool operator==(const FailingAllocator<U>&) const {
+    return true;
+  }
+};
+
+struct CountingResource : public std::pmr::memory_resource {
+  size_t allocated = 0;
+  size_t deallocated = 0;
+  size_t allocations = 0;
+
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    allocated += bytes;
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+    deallocated += bytes;
+    std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+      noexcept override {
+    return this == &other;
+  }
+};
+
 template <typename FirstList, typename SecondList>
 bool AreListsEqual(const FirstList& first, const SecondList& second) {
   if (first.size() != second.size()) {